@@ -4,24 +4,1342 @@
 * This software is released under the MIT License.
 * https://opensource.org/licenses/MIT
 */
+module;
+#include <lua.hpp>
+#include <LuaBridge/LuaBridge.h>
 module lysa.ecs.lua;
 
+import std;
 import vireo;
 import lysa.math;
 import lysa.ecs;
 
 namespace lysa::ecs {
 
-    void LuaBindings::_register(const lysa::Lua& lua) {
+    //! World of the entities passed to Lua
+    static flecs::world_t* luaWorld{nullptr};
+
+    // __index of the entities : the methods of ecs.entity then the getters of ecs.entity_properties
+    static int entityIndex(lua_State* L) {
+        lua_pushvalue(L, 2);
+        lua_gettable(L, lua_upvalueindex(1));
+        if (!lua_isnil(L, -1)) { return 1; }
+        lua_pop(L, 1);
+        lua_pushvalue(L, 2);
+        lua_gettable(L, lua_upvalueindex(2));
+        if (lua_isnil(L, -1)) { return 1; }
+        lua_pushvalue(L, 1);
+        lua_call(L, 1, 1);
+        return 1;
+    }
+
+    static int entityToString(lua_State* L) {
+        const auto id = static_cast<flecs::entity_t>(reinterpret_cast<std::uintptr_t>(lua_touserdata(L, 1)));
+        lua_pushstring(L, std::format("entity {}", id).c_str());
+        return 1;
+    }
+
+    // Sets the metatable shared by all the light userdata, the entity is on the top of the stack.
+    // Lua has one metatable for all the light userdata of a state : once an entity is pushed, the light
+    // userdata of the other libraries of the state also resolve their fields in ecs.entity.
+    // The ECS bindings require a Lua state where no other library uses light userdata
+    static void setEntityMetatable(lua_State* L) {
+        lua_createtable(L, 0, 2);
+        lua_getglobal(L, "ecs");
+        lua_getfield(L, -1, "entity");
+        lua_getfield(L, -2, "entity_properties");
+        lua_remove(L, -3);
+        lua_pushcclosure(L, &entityIndex, 2);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, &entityToString);
+        lua_setfield(L, -2, "__tostring");
+        lua_setmetatable(L, -2);
+    }
+
+}
+
+/**
+ * Entities are passed to Lua as light userdata holding the entity id, pushing an entity allocates nothing.
+ * The world is the one of the bindings, the methods and the properties are resolved by the metatable
+ * shared by all the light userdata of the Lua state.
+ * A light userdata is read back as an entity if it holds a well-formed entity id, alive or not :
+ * the functions using the entity check that it is alive, is_alive and id work on the destroyed entities.
+ * The null entity is pushed as nil
+ */
+template <>
+struct luabridge::Stack<flecs::entity> {
+    [[nodiscard]] static Result push(lua_State* L, const flecs::entity& e) {
+        if (!e.id()) {
+            lua_pushnil(L);
+            return {};
+        }
+        lua_pushlightuserdata(L, reinterpret_cast<void*>(static_cast<std::uintptr_t>(e.id())));
+        if (lua_getmetatable(L, -1)) {
+            lua_pop(L, 1);
+        } else {
+            lysa::ecs::setEntityMetatable(L);
+        }
+        return {};
+    }
+
+    [[nodiscard]] static TypeResult<flecs::entity> get(lua_State* L, const int index) {
+        if (!isInstance(L, index)) {
+            return makeErrorCode(ErrorCode::InvalidTypeCast);
+        }
+        return flecs::entity(lysa::ecs::luaWorld, getId(L, index));
+    }
+
+    [[nodiscard]] static bool isInstance(lua_State* L, const int index) {
+        if (!lua_islightuserdata(L, index)) { return false; }
+        const auto id = getId(L, index);
+        return id != 0 && (id & RESERVED_BITS) == 0;
+    }
+
+private:
+    //! Id flags (pairs, toggles...) and bits above the generation, never set in an entity id
+    static constexpr flecs::entity_t RESERVED_BITS{0xFFFF000000000000ull};
+
+    static flecs::entity_t getId(lua_State* L, const int index) {
+        return static_cast<flecs::entity_t>(reinterpret_cast<std::uintptr_t>(lua_touserdata(L, index)));
+    }
+};
+
+namespace lysa::ecs {
+
+    /**
+     * Position of an iteration from Lua, shared with the component views of the rows.
+     * The iterator is reset at the end of the iteration, the rows and views kept by a script are then invalid
+     */
+    struct LuaCursor {
+        flecs::iter* iter{nullptr};
+        size_t index{0};
+        //! Number of the current table of the iteration, the views on a fixed row are invalid in the next tables
+        uint32 table{0};
+    };
+
+    /**
+     * Points a cursor to an iteration for the lifetime of the scope, also when the iteration fails
+     */
+    class LuaCursorScope {
+    public:
+        LuaCursorScope(LuaCursor& cursor, flecs::iter& it): cursor(cursor) {
+            cursor.iter = &it;
+        }
+
+        ~LuaCursorScope() {
+            cursor.iter = nullptr;
+        }
+
+        LuaCursorScope(const LuaCursorScope&) = delete;
+        LuaCursorScope& operator=(const LuaCursorScope&) = delete;
+
+    private:
+        LuaCursor& cursor;
+    };
+
+    /**
+     * Current row of an iteration from Lua with the views on its components,
+     * one view per component for the whole iteration following the current row.
+     * The rows are owned by Lua and can outlive their iteration, they raise a Lua error once it ended
+     */
+    struct LuaRow {
+        std::shared_ptr<LuaCursor> cursor{std::make_shared<LuaCursor>()};
+        std::unordered_map<flecs::id_t, luabridge::LuaRef> views;
+
+        LuaRow() = default;
+        LuaRow(const LuaRow&) = delete;
+        LuaRow& operator=(const LuaRow&) = delete;
+
+        flecs::iter& getIter() const {
+            if (!cursor->iter) {
+                throw std::logic_error("ECS iteration ended, rows and tables can't be used after each() or run");
+            }
+            return *cursor->iter;
+        }
+    };
+
+    /**
+     * Current row of a query iteration from Lua, the same row is passed to the callback for all the entities
+     */
+    struct LuaQueryRow : LuaRow, std::enable_shared_from_this<LuaQueryRow> {};
+
+    /**
+     * Current table of a system defined in Lua, the same table is passed to the callback for all the matched tables.
+     * The component views returned by get() stay on their row
+     */
+    struct LuaSystemTable : LuaRow, std::enable_shared_from_this<LuaSystemTable> {};
+
+    /**
+     * Structural change made from Lua, queued until the next merge
+     */
+    struct LuaCommand {
+        enum class Type : uint8 { Add, Remove, Destruct };
+        flecs::entity_t entity;
+        Type type;
+        flecs::id_t id{0};
+        //! Sets the value of a component added with a value
+        std::function<void(const flecs::entity&)> set{};
+    };
+
+    /**
+     * Structural changes made from Lua, merged in the world once per frame by ecs::progress().
+     * Each Lua state is used by one thread at a time, the states running on different threads
+     * can queue their commands concurrently
+     */
+    class LuaCommandBuffer {
+    public:
+        /**
+         * Queues a command, can be called from any thread
+         */
+        void push(LuaCommand command) {
+            auto lock = std::lock_guard{mutex};
+            commands.push_back(std::move(command));
+        }
+
+        /**
+         * Applies the queued commands grouped by source table then by entity.
+         * Only the last command on each component of an entity is applied and
+         * the changes of an entity are merged by flecs into one table move.
+         * Must be called from the main thread only : the queue is swapped under the lock,
+         * the commands pushed during a merge are applied by the next one
+         */
+        void merge(const flecs::world& w) {
+            {
+                auto lock = std::lock_guard{mutex};
+                std::swap(commands, merging);
+            }
+            if (merging.empty()) { return; }
+            order.clear();
+            for (auto i = size_t{0}; i < merging.size(); ++i) {
+                const auto entity = merging[i].entity;
+                const auto* record = ecs_is_alive(w.c_ptr(), entity) ? ecs_record_find(w.c_ptr(), entity) : nullptr;
+                order.emplace_back(reinterpret_cast<std::uintptr_t>(record ? record->table : nullptr), entity, i);
+            }
+            // Stable on the index : the commands of an entity keep the order they were queued in
+            std::ranges::sort(order);
+            w.defer_begin();
+            for (auto first = order.begin(); first != order.end();) {
+                const auto entity = std::get<1>(*first);
+                const auto last = std::find_if(first, order.end(), [entity](const auto& o) {
+                    return std::get<1>(o) != entity;
+                });
+                apply(flecs::entity(w, entity), first, last);
+                first = last;
+            }
+            w.defer_end();
+            merging.clear();
+        }
+
+    private:
+        using Order = std::vector<std::tuple<std::uintptr_t, flecs::entity_t, size_t>>;
+        std::mutex mutex;
+        std::vector<LuaCommand> commands;
+        //! Commands being merged, swapped with the queue to keep both allocations
+        std::vector<LuaCommand> merging;
+        Order order;
+
+        void apply(const flecs::entity& e, const Order::iterator first, const Order::iterator last) const {
+            if (!e.is_alive()) { return; }
+            const auto destruct = std::any_of(first, last, [&](const auto& o) {
+                return merging[std::get<2>(o)].type == LuaCommand::Type::Destruct;
+            });
+            if (destruct) {
+                e.destruct();
+                return;
+            }
+            for (auto it = first; it != last; ++it) {
+                const auto& command = merging[std::get<2>(*it)];
+                const auto overridden = std::any_of(it + 1, last, [&](const auto& o) {
+                    return merging[std::get<2>(o)].id == command.id;
+                });
+                if (overridden) { continue; }
+                if (command.type == LuaCommand::Type::Remove) {
+                    e.remove(command.id);
+                } else if (command.set) {
+                    command.set(e);
+                } else {
+                    e.add(command.id);
+                }
+            }
+        }
+    };
+
+    static LuaCommandBuffer luaCommands;
+    //! ECSConfiguration::luaDeferredCommands
+    static bool luaDeferredCommands{false};
+
+    /**
+     * Hook-based Lua profiler recording the Lua functions and the native functions called from Lua
+     * as Profiler scopes : "Lua.<function> (<source>:<line>)" and "Lua.native.<function>"
+     */
+    class LuaProfiler {
+    public:
+        //! Prefix of the scopes of the native functions, one per transition from Lua to C++
+        static constexpr auto NATIVE_PREFIX = std::string_view{"Lua.native."};
+
+        /**
+         * Installs or removes the hook on the main Lua thread, the coroutines created after inherit it
+         */
+        static void setEnabled(lua_State* L, const bool enabled) {
+            if constexpr (PROFILER_ENABLED) {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+                auto* main = lua_tothread(L, -1);
+                lua_pop(L, 1);
+                lua_sethook(main, enabled ? &hook : nullptr, enabled ? LUA_MASKCALL | LUA_MASKRET : 0, 0);
+            }
+        }
+
+    private:
+        struct Call {
+            const void* function;
+            const char* name;
+            uint64 start;
+        };
+
+        //! Scope name of a function, with the source, line and name used to detect a reused address
+        struct Name {
+            std::string source;
+            int line;
+            std::string function;
+            const char* scope;
+
+            bool matches(const lua_Debug* ar, const std::string_view function) const {
+                return line == ar->linedefined && this->function == function && source == ar->short_src;
+            }
+        };
+
+        //! Calls in progress of each Lua thread running on this thread
+        static inline thread_local std::unordered_map<lua_State*, std::vector<Call>> calls;
+        //! Names already resolved by this thread, avoids the global lock on each call
+        static inline thread_local std::unordered_map<const void*, Name> localNames;
+        static inline std::mutex namesMutex;
+        static inline std::unordered_map<const void*, Name> names;
+        // The profiler keeps the scopes names until the end of the program
+        static inline std::deque<std::string> namesStorage;
+
+        static void hook(lua_State* L, lua_Debug* ar) {
+            // Tail calls replace the caller and return once for both
+            if (ar->event == LUA_HOOKTAILCALL) { return; }
+            lua_getinfo(L, "f", ar);
+            const auto* function = lua_topointer(L, -1);
+            lua_pop(L, 1);
+            auto& stack = calls[L];
+            if (ar->event == LUA_HOOKCALL) {
+                stack.push_back({ function, getName(L, ar, function), Profiler::now() });
+                return;
+            }
+            // The frames unwound by an error never returned, they are dropped
+            const auto call = std::ranges::find(stack.rbegin(), stack.rend(), function, &Call::function);
+            if (call == stack.rend()) { return; }
+            Profiler::record(call->name, call->start, Profiler::now() - call->start);
+            stack.erase(std::prev(call.base()), stack.end());
+            if (stack.empty()) {
+                calls.erase(L);
+            }
+        }
+
+        // The functions are keyed by address but the GC can reuse the address of a collected function,
+        // the cached names are checked against the source, line and name of the called function
+        static const char* getName(lua_State* L, lua_Debug* ar, const void* function) {
+            lua_getinfo(L, "Sn", ar);
+            const auto name = std::string_view{ar->name ? ar->name : "?"};
+            if (const auto it = localNames.find(function); it != localNames.end() && it->second.matches(ar, name)) {
+                return it->second.scope;
+            }
+            auto lock = std::lock_guard{namesMutex};
+            auto it = names.find(function);
+            if (it == names.end() || !it->second.matches(ar, name)) {
+                const auto& scope = *ar->what == 'C' ?
+                    namesStorage.emplace_back(std::format("{}{}", NATIVE_PREFIX, name)) :
+                    namesStorage.emplace_back(std::format("Lua.{} ({}:{})", name, ar->short_src, ar->linedefined));
+                it = names.insert_or_assign(
+                    function,
+                    Name{ ar->short_src, ar->linedefined, std::string{name}, scope.c_str() }).first;
+            }
+            return (localNames[function] = it->second).scope;
+        }
+    };
+
+    /**
+     * Location of a component of an entity in its table column.
+     * It is validated against the entity record at each access : it follows the entity when it moves
+     * to another table and is invalid once the entity or the component is gone.
+     * A reference on a cursor follows the current row of an iteration instead of an entity,
+     * or stays on one row of the current table of the iteration
+     */
+    class LuaComponentRef {
+    public:
+        LuaComponentRef(const flecs::entity& e, const flecs::id_t component, const size_t size):
+            world(e.world().c_ptr()),
+            entity(e.id()),
+            component(component),
+            size(size),
+            record(ecs_record_find(world, entity)) {
+        }
+
+        LuaComponentRef(
+            std::shared_ptr<const LuaCursor> cursor,
+            const flecs::id_t component,
+            const size_t size,
+            const std::optional<size_t> index = std::nullopt):
+            world(luaWorld),
+            component(component),
+            size(size),
+            cursor(std::move(cursor)),
+            index(index),
+            cursorTable(this->cursor->table) {
+        }
+
+        /**
+         * Returns the address of the component, nullptr if the entity or the component is gone
+         */
+        void* get() const {
+            if (!isValid()) { return nullptr; }
+            if (cursor) {
+                const auto* it = cursor->iter->c_ptr();
+                return ecs_table_get_column(table, column, it->offset + static_cast<int32>(getIndex()));
+            }
+            // flecs stores flags in the high bits of the row
+            return static_cast<std::byte*>(ecs_table_get_column(table, column, 0)) + (record->row & 0x0FFFFFFFu) * size;
+        }
+
+        /**
+         * Returns true if the entity is alive and still has the component
+         */
+        bool isValid() const {
+            if (cursor) {
+                return isOnRow() && findColumn(cursor->iter->c_ptr()->table);
+            }
+            return ecs_is_alive(world, entity) && findColumn(record->table);
+        }
+
+        flecs::entity getEntity() const {
+            if (cursor) {
+                return isOnRow() ? cursor->iter->entity(getIndex()) : flecs::entity{};
+            }
+            return flecs::entity(world, entity);
+        }
+
+        flecs::id_t getComponent() const { return component; }
+
+    private:
+        flecs::world_t* world;
+        flecs::entity_t entity{0};
+        flecs::id_t component;
+        size_t size;
+        ecs_record_t* record{nullptr};
+        std::shared_ptr<const LuaCursor> cursor;
+        //! Row of a reference on a cursor, the current row of the cursor when empty
+        std::optional<size_t> index;
+        uint32 cursorTable{0};
+        mutable flecs::table_t* table{nullptr};
+        mutable int32 column{-1};
+
+        size_t getIndex() const { return index.value_or(cursor->index); }
+
+        // The iteration is running and, for a fixed row, still on the table of the row
+        bool isOnRow() const { return cursor->iter && (!index || cursor->table == cursorTable); }
+
+        bool findColumn(flecs::table_t* current) const {
+            if (current != table) {
+                // The entity moved or the iteration reached another table,
+                // the column of the component in the new table is looked up once
+                table = current;
+                column = table ? ecs_table_get_column_index(world, table, component) : -1;
+            }
+            return column != -1;
+        }
+    };
+
+    /**
+     * View on a component of an entity, the fields are read and written in place in the table column
+     */
+    template <typename T>
+    class LuaComponentView {
+    public:
+        explicit LuaComponentView(const flecs::entity& e):
+            ref(e, e.world().id<T>(), sizeof(T)) {
+        }
+
+        LuaComponentView(
+            std::shared_ptr<const LuaCursor> cursor,
+            const flecs::id_t id,
+            const std::optional<size_t> index = std::nullopt):
+            ref(std::move(cursor), id, sizeof(T), index) {
+        }
+
+        T& get() const {
+            auto* component = ref.get();
+            if (!component) {
+                throw std::runtime_error("Stale ECS component view");
+            }
+            return *static_cast<T*>(component);
+        }
+
+        bool isValid() const { return ref.isValid(); }
+
+        flecs::entity getEntity() const { return ref.getEntity(); }
+
+    private:
+        LuaComponentRef ref;
+    };
+
+    /**
+     * Field of a component described with flecs meta, copied from and to its offset in the component
+     */
+    struct LuaField {
+        enum class Type : uint8 { Bool, Float, Double, Int32, UInt32, Int64, UInt64, Entity };
+        std::string name;
+        Type type;
+        uint32 offset;
+    };
+
+    /**
+     * Lua accessors of a component, generated once from its flecs meta description.
+     * The fields of the member types without a Lua equivalent are not reachable
+     */
+    struct LuaReflectedComponent {
+        size_t size;
+        std::vector<LuaField> fields;
+
+        const LuaField* find(const std::string_view name) const {
+            const auto it = std::ranges::find(fields, name, &LuaField::name);
+            return it == fields.end() ? nullptr : &*it;
+        }
+
+        // Returns the accessors of a component, nullptr if the component has no meta description
+        static const LuaReflectedComponent* get(const flecs::world& w, const flecs::id_t id);
+
+    private:
+        static std::optional<LuaField::Type> getType(const flecs::entity_t type) {
+            if (type == flecs::Bool) { return LuaField::Type::Bool; }
+            if (type == flecs::F32) { return LuaField::Type::Float; }
+            if (type == flecs::F64) { return LuaField::Type::Double; }
+            if (type == flecs::I32) { return LuaField::Type::Int32; }
+            if (type == flecs::U32) { return LuaField::Type::UInt32; }
+            if (type == flecs::I64) { return LuaField::Type::Int64; }
+            if (type == flecs::U64) { return LuaField::Type::UInt64; }
+            if (type == flecs::Entity) { return LuaField::Type::Entity; }
+            return std::nullopt;
+        }
+    };
+
+    /**
+     * Accessors of the reflected components of a world, stored as a world singleton.
+     * The component ids are only valid in their world
+     */
+    struct LuaReflectedComponents {
+        std::unordered_map<flecs::id_t, LuaReflectedComponent> components;
+    };
+
+    const LuaReflectedComponent* LuaReflectedComponent::get(const flecs::world& w, const flecs::id_t id) {
+        auto& components = w.get_mut<LuaReflectedComponents>().components;
+        if (const auto it = components.find(id); it != components.end()) {
+            return &it->second;
+        }
+        const auto e = w.entity(id);
+        const auto* description = e.try_get<flecs::Struct>();
+        const auto* type = e.try_get<flecs::Component>();
+        if (!description || !type) { return nullptr; }
+        auto component = LuaReflectedComponent{ .size = static_cast<size_t>(type->size) };
+        const auto* members = static_cast<const flecs::member_t*>(description->members.array);
+        for (auto i = 0; i < description->members.count; ++i) {
+            const auto& member = members[i];
+            if (member.count > 1) { continue; }
+            if (const auto fieldType = getType(member.type)) {
+                component.fields.push_back({ member.name, *fieldType, static_cast<uint32>(member.offset) });
+            }
+        }
+        return &components.emplace(id, std::move(component)).first->second;
+    }
+
+    /**
+     * Userdata of the views on the components described with flecs meta
+     */
+    struct LuaReflectedView {
+        LuaComponentRef ref;
+        const LuaReflectedComponent* component;
+
+        static constexpr auto METATABLE = "ecs.ComponentView";
+
+        // Pushes a view on a component of an entity, raises a Lua error if the component has no meta description
+        static int push(lua_State* L, const flecs::entity& e, const flecs::id_t id) {
+            const auto* component = LuaReflectedComponent::get(e.world(), id);
+            if (!component) {
+                return luaL_error(L, "ECS component without meta description");
+            }
+            return push(L, LuaComponentRef{e, id, component->size}, component);
+        }
+
+        // Pushes a view on a component of the current row of an iteration, or of one row of the current table
+        static int push(
+            lua_State* L,
+            std::shared_ptr<const LuaCursor> cursor,
+            const flecs::id_t id,
+            const std::optional<size_t> index = std::nullopt) {
+            const auto* component = LuaReflectedComponent::get(flecs::world(luaWorld), id);
+            if (!component) {
+                return luaL_error(L, "ECS component without meta description");
+            }
+            return push(L, LuaComponentRef{std::move(cursor), id, component->size, index}, component);
+        }
+
+    private:
+        static int push(lua_State* L, LuaComponentRef ref, const LuaReflectedComponent* component) {
+            auto* view = static_cast<LuaReflectedView*>(lua_newuserdatauv(L, sizeof(LuaReflectedView), 0));
+            std::construct_at(view, std::move(ref), component);
+            if (luaL_newmetatable(L, METATABLE)) {
+                lua_pushcfunction(L, &index);
+                lua_setfield(L, -2, "__index");
+                lua_pushcfunction(L, &newIndex);
+                lua_setfield(L, -2, "__newindex");
+                lua_pushcfunction(L, &gc);
+                lua_setfield(L, -2, "__gc");
+            }
+            lua_setmetatable(L, -2);
+            return 1;
+        }
+
+        // The views on a cursor share it with the row
+        static int gc(lua_State* L) {
+            std::destroy_at(static_cast<LuaReflectedView*>(lua_touserdata(L, 1)));
+            return 0;
+        }
+
+        static int index(lua_State* L) {
+            const auto* view = static_cast<LuaReflectedView*>(luaL_checkudata(L, 1, METATABLE));
+            const auto name = std::string_view{luaL_checkstring(L, 2)};
+            if (name == "is_valid") {
+                lua_pushboolean(L, view->ref.isValid());
+                return 1;
+            }
+            if (name == "entity") {
+                std::ignore = luabridge::Stack<flecs::entity>::push(L, view->ref.getEntity());
+                return 1;
+            }
+            const auto* field = view->component->find(name);
+            if (!field) {
+                return luaL_error(L, "Unknown ECS component field %s", name.data());
+            }
+            const auto* data = static_cast<const std::byte*>(view->ref.get());
+            if (!data) {
+                return luaL_error(L, "Stale ECS component view");
+            }
+            data += field->offset;
+            switch (field->type) {
+            case LuaField::Type::Bool:
+                lua_pushboolean(L, read<bool>(data));
+                break;
+            case LuaField::Type::Float:
+                lua_pushnumber(L, read<float>(data));
+                break;
+            case LuaField::Type::Double:
+                lua_pushnumber(L, read<double>(data));
+                break;
+            case LuaField::Type::Int32:
+                lua_pushinteger(L, read<std::int32_t>(data));
+                break;
+            case LuaField::Type::UInt32:
+                lua_pushinteger(L, read<std::uint32_t>(data));
+                break;
+            case LuaField::Type::Int64:
+                lua_pushinteger(L, read<std::int64_t>(data));
+                break;
+            case LuaField::Type::UInt64:
+                lua_pushinteger(L, static_cast<lua_Integer>(read<std::uint64_t>(data)));
+                break;
+            case LuaField::Type::Entity:
+                std::ignore = luabridge::Stack<flecs::entity>::push(
+                    L, view->ref.getEntity().world().entity(read<flecs::entity_t>(data)));
+                break;
+            }
+            return 1;
+        }
+
+        static int newIndex(lua_State* L) {
+            const auto* view = static_cast<LuaReflectedView*>(luaL_checkudata(L, 1, METATABLE));
+            const auto name = std::string_view{luaL_checkstring(L, 2)};
+            const auto* field = view->component->find(name);
+            if (!field) {
+                return luaL_error(L, "Unknown ECS component field %s", name.data());
+            }
+            auto* data = static_cast<std::byte*>(view->ref.get());
+            if (!data) {
+                return luaL_error(L, "Stale ECS component view");
+            }
+            data += field->offset;
+            switch (field->type) {
+            case LuaField::Type::Bool:
+                write(data, static_cast<bool>(lua_toboolean(L, 3)));
+                break;
+            case LuaField::Type::Float:
+                write(data, static_cast<float>(luaL_checknumber(L, 3)));
+                break;
+            case LuaField::Type::Double:
+                write(data, static_cast<double>(luaL_checknumber(L, 3)));
+                break;
+            case LuaField::Type::Int32:
+                write(data, static_cast<std::int32_t>(luaL_checkinteger(L, 3)));
+                break;
+            case LuaField::Type::UInt32:
+                write(data, static_cast<std::uint32_t>(luaL_checkinteger(L, 3)));
+                break;
+            case LuaField::Type::Int64:
+                write(data, static_cast<std::int64_t>(luaL_checkinteger(L, 3)));
+                break;
+            case LuaField::Type::UInt64:
+                write(data, static_cast<std::uint64_t>(luaL_checkinteger(L, 3)));
+                break;
+            case LuaField::Type::Entity: {
+                const auto e = luabridge::Stack<flecs::entity>::get(L, 3);
+                if (!e) {
+                    return luaL_error(L, "ECS component field %s is an entity", name.data());
+                }
+                write(data, e->id());
+                break;
+            }
+            }
+            // Runs the OnSet observers, like a set from C++
+            view->ref.getEntity().modified(view->ref.getComponent());
+            return 0;
+        }
+
+        template <typename T>
+        static T read(const std::byte* data) {
+            auto value = T{};
+            std::memcpy(&value, data, sizeof(T));
+            return value;
+        }
+
+        template <typename T>
+        static void write(std::byte* data, const T value) {
+            std::memcpy(data, &value, sizeof(T));
+        }
+    };
+
+    // Components read through one view per iteration following the current row : TransformView
+    // and the reflected views of the components whose Lua class properties all have a meta member.
+    // The others are pushed as a new reference for each row
+    template <typename T>
+    constexpr bool hasRowView =
+        std::is_same_v<T, Transform> ||
+        std::is_same_v<T, Camera> ||
+        std::is_same_v<T, MaterialOverride> ||
+        std::is_same_v<T, RenderTarget>;
+
+    /**
+     * Components reachable from Lua.
+     * The entity add, has and remove methods find the component functions with one lookup
+     * in the tables generated from this list, indexed by the component_id property of the component classes
+     */
+    template <typename... Components>
+    struct LuaComponentList {
+        template <typename T>
+        static uint32 componentId() {
+            static_assert((std::is_same_v<T, Components> || ...), "Component not in the Lua components list");
+            constexpr bool matches[] = { std::is_same_v<T, Components>... };
+            return static_cast<uint32>(std::ranges::find(matches, true) - std::ranges::begin(matches));
+        }
+
+        template <typename T>
+        static uint32 getId(const T*) {
+            return componentId<T>();
+        }
+
+        //! Returns the flecs id of a component class or instance
+        static flecs::id_t getComponent(const flecs::world& w, const luabridge::LuaRef& component) {
+            return idFunctions[getId(component)](w);
+        }
+
+        //! Returns a view on the component of the current row, or of one row of the current table when
+        //! the index is given, true or false for the tags and nil if the table of the row does not have the component
+        static luabridge::LuaRef get(
+            LuaRow& row,
+            const luabridge::LuaRef& component,
+            const std::optional<size_t> index = std::nullopt) {
+            return getFunctions[getId(component)](row, component, index);
+        }
+
+        static flecs::entity add(const flecs::entity& e, const luabridge::LuaRef& component) {
+            return addFunctions[getId(component)](e, component);
+        }
+
+        static bool has(const flecs::entity& e, const luabridge::LuaRef& component) {
+            return hasFunctions[getId(component)](e);
+        }
+
+        static flecs::entity remove(const flecs::entity& e, const luabridge::LuaRef& component) {
+            return removeFunctions[getId(component)](e);
+        }
+
+        //! Returns the command adding a component, with a copy of the value of the component instances
+        static LuaCommand addCommand(const flecs::entity& e, const luabridge::LuaRef& component) {
+            return addCommandFunctions[getId(component)](e, component);
+        }
+
+    private:
+        template <typename T>
+        static flecs::entity add(const flecs::entity& e, const luabridge::LuaRef& component) {
+            // The scenes contexts are created by the observers when the component is added
+            if constexpr (std::is_empty_v<T> || std::is_same_v<T, Scene>) {
+                return e.add<T>();
+            } else {
+                return e.set<T>(component.unsafe_cast<const T&>());
+            }
+        }
+
+        template <typename T>
+        static LuaCommand addCommand(const flecs::entity& e, const luabridge::LuaRef& component) {
+            auto command = LuaCommand{ .entity = e.id(), .type = LuaCommand::Type::Add, .id = e.world().id<T>() };
+            if constexpr (!std::is_empty_v<T> && !std::is_same_v<T, Scene>) {
+                command.set = [value = component.unsafe_cast<T>()](const flecs::entity& target) {
+                    target.set<T>(value);
+                };
+            }
+            return command;
+        }
+
+        template <typename T>
+        static flecs::id_t id(const flecs::world& w) {
+            return w.id<T>();
+        }
+
+        template <typename T>
+        static luabridge::LuaRef get(LuaRow& row, const luabridge::LuaRef& component, const std::optional<size_t> index) {
+            auto* L = component.state();
+            const auto& it = row.getIter();
+            if constexpr (std::is_empty_v<T>) {
+                return luabridge::LuaRef(L, it.range().has<T>());
+            } else {
+                // optional terms and components not in the query
+                if (!it.range().has<T>()) { return luabridge::LuaRef(L); }
+                if constexpr (hasRowView<T>) {
+                    const auto id = it.world().id<T>();
+                    // The views following the current row are created once, the views on a fixed row each time
+                    if (!index) {
+                        if (const auto view = row.views.find(id); view != row.views.end()) {
+                            return view->second;
+                        }
+                    }
+                    auto view = luabridge::LuaRef(L);
+                    if constexpr (std::is_same_v<T, Transform>) {
+                        view = luabridge::LuaRef(L, LuaComponentView<T>{row.cursor, id, index});
+                    } else {
+                        LuaReflectedView::push(L, row.cursor, id, index);
+                        view = luabridge::LuaRef::fromStack(L, -1);
+                        lua_pop(L, 1);
+                    }
+                    if (index) { return view; }
+                    return row.views.emplace(id, std::move(view)).first->second;
+                } else {
+                    return luabridge::LuaRef(L, &it.range().get<T>()[index.value_or(row.cursor->index)]);
+                }
+            }
+        }
+
+        template <typename T>
+        static bool has(const flecs::entity& e) {
+            return e.has<T>();
+        }
+
+        template <typename T>
+        static flecs::entity remove(const flecs::entity& e) {
+            return e.remove<T>();
+        }
+
+        static constexpr auto addFunctions = std::array{ &add<Components>... };
+        static constexpr auto hasFunctions = std::array{ &has<Components>... };
+        static constexpr auto removeFunctions = std::array{ &remove<Components>... };
+        static constexpr auto addCommandFunctions = std::array{ &addCommand<Components>... };
+        static constexpr auto idFunctions = std::array{ &id<Components>... };
+        static constexpr auto getFunctions = std::array{ &get<Components>... };
+
+        static uint32 getId(const luabridge::LuaRef& component) {
+            const luabridge::LuaRef id = component["component_id"];
+            if (!id.isNumber() || id.unsafe_cast<uint32>() >= sizeof...(Components)) {
+                throw std::invalid_argument("Not an ECS component");
+            }
+            return id.unsafe_cast<uint32>();
+        }
+    };
+
+    using LuaComponents = LuaComponentList<
+        RenderTarget,
+        Viewport,
+        Camera,
+        CameraRef,
+        MaterialOverride,
+        MeshInstance,
+        Scene,
+        SceneRef,
+        AmbientLight,
+        Visible,
+        Transform>;
+
+    /**
+     * Query created from Lua, the matching entities are iterated table by table.
+     * Building a query is costly, scripts should keep and reuse their queries
+     */
+    class LuaQuery {
+    public:
+        LuaQuery(const flecs::world& w, const luabridge::LuaRef& components):
+            world(w.c_ptr()) {
+            auto builder = w.query_builder<>();
+            for (auto i = 1; i <= components.length(); ++i) {
+                builder.with(LuaComponents::getComponent(w, components[i]));
+            }
+            query = builder.build();
+        }
+
+        /**
+         * Calls the callback for each matching entity with a LuaQueryRow.
+         * The iteration is deferred so the callback can add and remove components
+         */
+        void each(const luabridge::LuaRef& callback) const {
+            // One row userdata and one view per component for all the entities
+            const auto row = std::make_shared<LuaQueryRow>();
+            const auto rowRef = luabridge::LuaRef(callback.state(), row);
+            auto error = std::string{};
+            {
+                const auto defer = DeferScope{flecs::world(world)};
+                query.run([&](flecs::iter& it) {
+                    const auto scope = LuaCursorScope{*row->cursor, it};
+                    while (it.next()) {
+                        row->cursor->table += 1;
+                        for (const auto i : it) {
+                            row->cursor->index = i;
+                            if (const auto result = callback(rowRef); result.hasFailed()) {
+                                error = result.errorMessage();
+                                it.fini();
+                                return;
+                            }
+                        }
+                    }
+                });
+            }
+            if (!error.empty()) {
+                throw std::runtime_error(error);
+            }
+        }
+
+        int32 count() const {
+            return query.count();
+        }
+
+    private:
+        flecs::world_t* world;
+        flecs::query<> query;
+    };
+
+    // Adds an entity or a pair to an entity, now or at the next merge
+    static flecs::entity add(const flecs::entity& e, const flecs::id_t id) {
+        if (luaDeferredCommands) {
+            luaCommands.push({ .entity = e.id(), .type = LuaCommand::Type::Add, .id = id });
+            return e;
+        }
+        return e.add(id);
+    }
+
+    static flecs::entity add(const flecs::entity& e, const flecs::entity_t first, const flecs::entity_t second) {
+        return add(e, e.world().pair(first, second));
+    }
+
+    // Removes an entity or a pair from an entity, now or at the next merge
+    static flecs::entity remove(const flecs::entity& e, const flecs::id_t id) {
+        if (luaDeferredCommands) {
+            luaCommands.push({ .entity = e.id(), .type = LuaCommand::Type::Remove, .id = id });
+            return e;
+        }
+        return e.remove(id);
+    }
+
+    void LuaBindings::mergeCommands(const flecs::world& world) {
+        luaCommands.merge(world);
+    }
+
+    uint64 LuaBindings::getNativeCalls(const uint64 frame) {
+        auto count = uint64{0};
+        for (const auto& stat : Profiler::getFrameStats(frame)) {
+            if (std::string_view{stat.name}.starts_with(LuaProfiler::NATIVE_PREFIX)) {
+                count += stat.count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Tag of the entities running a Lua behavior
+     */
+    struct LuaBehavior {};
+
+    /**
+     * Tag of the systems defined in Lua, their callbacks are destroyed with the system
+     */
+    struct LuaSystem {};
+
+    /**
+     * Runs one Lua coroutine per entity, stored as a world singleton.
+     *
+     * A behavior yields with ecs.wait(seconds), ecs.wait_event(name) or coroutine.yield() for the next frame.
+     * The waiting behaviors are not visited : the timers are kept in a heap and the events
+     * in lists of waiting behaviors. The ready behaviors are resumed in order until
+     * ECSConfiguration::luaBehaviorsBudget is exceeded, the others are resumed first the next frame
+     */
+    class LuaScheduler {
+    public:
+        void start(const flecs::entity& e, const luabridge::LuaRef& function) {
+            auto* L = function.state();
+            auto* thread = lua_newthread(L);
+            auto coroutine = luabridge::LuaRef::fromStack(L, -1);
+            lua_pop(L, 1);
+            // The function and its argument wait on the coroutine stack for the first resume
+            function.push(thread);
+            std::ignore = luabridge::Stack<flecs::entity>::push(thread, e);
+            removeEvents(e.id());
+            behaviors.insert_or_assign(e.id(), Behavior{ std::move(coroutine), thread, ++serials, serials });
+            ready.push_back({ e.id(), serials });
+            e.add<LuaBehavior>();
+            e.remove<LuaError>();
+        }
+
+        /**
+         * Removes the LuaBehavior tag of the entity. The remove is deferred in the pipeline,
+         * the behaviors started after the request and before the merge are kept
+         */
+        void requestStop(const flecs::entity& e) {
+            if (!e.has<LuaBehavior>()) { return; }
+            stops.insert_or_assign(e.id(), serials);
+            e.remove<LuaBehavior>();
+        }
+
+        /**
+         * Stops the behavior of the entity, called when the LuaBehavior tag is removed
+         */
+        void stop(const flecs::entity_t entity) {
+            if (const auto request = stops.find(entity); request != stops.end()) {
+                const auto serial = request->second;
+                stops.erase(request);
+                const auto it = behaviors.find(entity);
+                if (it != behaviors.end() && it->second.started > serial) { return; }
+            }
+            behaviors.erase(entity);
+            removeEvents(entity);
+        }
+
+        /**
+         * Makes the behaviors waiting for the event ready
+         */
+        void emit(const std::string& event) {
+            const auto it = events.find(event);
+            if (it == events.end()) { return; }
+            for (const auto& wait : it->second) {
+                ready.push_back(wait);
+            }
+            events.erase(it);
+        }
+
+        void update(const flecs::world& w, const float deltaTime, const std::chrono::microseconds budget) {
+            time += deltaTime;
+            while (!timers.empty() && timers.top().time <= time) {
+                ready.push_back(timers.top().wait);
+                timers.pop();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            // The behaviors made ready during the update run the next frame
+            for (auto count = ready.size(); count > 0 && !ready.empty(); --count) {
+                if (budget.count() > 0 && std::chrono::steady_clock::now() - start >= budget) { break; }
+                const auto wait = ready.front();
+                ready.pop_front();
+                resume(w, wait);
+            }
+        }
+
+    private:
+        struct Behavior {
+            luabridge::LuaRef coroutine;
+            lua_State* thread;
+            //! Serial of the current wait, the queued waits with another serial are stale
+            uint64 serial;
+            //! Serial of the start of the behavior
+            uint64 started;
+        };
+
+        struct Wait {
+            flecs::entity_t entity;
+            uint64 serial;
+        };
+
+        struct Timer {
+            double time;
+            Wait wait;
+
+            bool operator>(const Timer& other) const { return time > other.time; }
+        };
+
+        std::unordered_map<flecs::entity_t, Behavior> behaviors;
+        std::deque<Wait> ready;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers;
+        std::unordered_map<std::string, std::vector<Wait>> events;
+        //! Last serial at the time of the pending stop requests
+        std::unordered_map<flecs::entity_t, uint64> stops;
+        double time{0.0};
+        uint64 serials{0};
+
+        // The stale timers are dropped when they expire, the events may never be emitted
+        void removeEvents(const flecs::entity_t entity) {
+            std::erase_if(events, [entity](auto& event) {
+                std::erase_if(event.second, [entity](const Wait& wait) { return wait.entity == entity; });
+                return event.second.empty();
+            });
+        }
+
+        void resume(const flecs::world& w, const Wait& wait) {
+            auto it = behaviors.find(wait.entity);
+            if (it == behaviors.end() || it->second.serial != wait.serial) { return; }
+            // The entity was destroyed with a behavior started after a stop request
+            if (!ecs_is_alive(w.c_ptr(), wait.entity)) {
+                behaviors.erase(it);
+                removeEvents(wait.entity);
+                return;
+            }
+            auto* thread = it->second.thread;
+            // Keeps the coroutine alive if the behavior is replaced while it runs
+            const auto coroutine = it->second.coroutine;
+            auto results = 0;
+            const auto status = lua_resume(thread, nullptr, lua_status(thread) == LUA_YIELD ? 0 : 1, &results);
+            // The behavior can start or stop behaviors, including its own
+            it = behaviors.find(wait.entity);
+            if (it == behaviors.end() || it->second.serial != wait.serial) { return; }
+            if (status == LUA_YIELD) {
+                it->second.serial = ++serials;
+                const auto next = Wait{ wait.entity, it->second.serial };
+                if (results > 0 && lua_type(thread, -results) == LUA_TNUMBER) {
+                    timers.push({ time + lua_tonumber(thread, -results), next });
+                } else if (results > 0 && lua_type(thread, -results) == LUA_TSTRING) {
+                    events[lua_tostring(thread, -results)].push_back(next);
+                } else {
+                    ready.push_back(next);
+                }
+                lua_pop(thread, results);
+                return;
+            }
+            const auto error = status == LUA_OK ?
+                std::string{} :
+                std::format("Lua behavior stopped : {}", luaL_tolstring(thread, -1, nullptr));
+            behaviors.erase(it);
+            if (const auto e = flecs::entity(w, wait.entity); e.is_alive()) {
+                requestStop(e);
+                if (!error.empty()) {
+                    e.set<LuaError>({ error });
+                }
+            }
+        }
+    };
+
+    // Yields the running behavior for a number of seconds
+    static int luaWait(lua_State* L) {
+        luaL_checknumber(L, 1);
+        lua_settop(L, 1);
+        return lua_yield(L, 1);
+    }
+
+    // Yields the running behavior until the event is emitted
+    static int luaWaitEvent(lua_State* L) {
+        luaL_checkstring(L, 1);
+        lua_settop(L, 1);
+        return lua_yield(L, 1);
+    }
+
+    // Returns the phase of a system defined in Lua
+    static flecs::entity_t getPhase(const flecs::world& w, const std::string& phase) {
+        if (phase == "OnLoad") { return flecs::OnLoad; }
+        if (phase == "PostLoad") { return flecs::PostLoad; }
+        if (phase == "PreUpdate") { return flecs::PreUpdate; }
+        if (phase == "OnUpdate") { return flecs::OnUpdate; }
+        if (phase == "OnValidate") { return flecs::OnValidate; }
+        if (phase == "PostUpdate") { return flecs::PostUpdate; }
+        if (phase == "PreStore") { return flecs::PreStore; }
+        if (phase == "OnStore") { return flecs::OnStore; }
+        if (phase == "FixedUpdate") { return w.id<FixedUpdate>(); }
+        if (phase == "FixedPostUpdate") { return w.id<FixedPostUpdate>(); }
+        throw std::invalid_argument("Unknown ECS phase " + phase);
+    }
+
+    /**
+     * Creates a system defined in Lua from a table with the fields :
+     * name (optional), query (array of component classes), phase (flecs phase name, OnUpdate by default),
+     * interval (seconds, optional) and run (function called with a LuaSystemTable for each matched table)
+     */
+    static flecs::entity createSystem(const flecs::world& w, const luabridge::LuaRef& desc) {
+        // The profiler keeps the scopes names until the end of the program
+        static auto profileNames = std::deque<std::string>{};
+        const luabridge::LuaRef nameRef = desc["name"];
+        const luabridge::LuaRef query = desc["query"];
+        const luabridge::LuaRef phase = desc["phase"];
+        const luabridge::LuaRef interval = desc["interval"];
+        const luabridge::LuaRef callback = desc["run"];
+        if (!callback.isFunction()) {
+            throw std::invalid_argument("Lua system without run function");
+        }
+        const auto name = nameRef.isString() ? nameRef.unsafe_cast<std::string>() : std::string{};
+        auto builder = w.system<>(name.empty() ? nullptr : name.c_str());
+        if (query.isTable()) {
+            for (auto i = 1; i <= query.length(); ++i) {
+                builder.with(LuaComponents::getComponent(w, query[i]));
+            }
+        }
+        builder.kind(getPhase(w, phase.isString() ? phase.unsafe_cast<std::string>() : "OnUpdate"));
+        if (interval.isNumber()) {
+            builder.interval(interval.unsafe_cast<float>());
+        }
+        const auto* profileName = profileNames.emplace_back("Lua." + (name.empty() ? "system" : name)).c_str();
+        const auto system = builder.run([callback, profileName](flecs::iter& it) {
+            const auto profile = ProfilerScope{profileName};
+            // One table userdata for all the tables
+            const auto table = std::make_shared<LuaSystemTable>();
+            const auto tableRef = luabridge::LuaRef(callback.state(), table);
+            const auto scope = LuaCursorScope{*table->cursor, it};
+            while (it.next()) {
+                table->cursor->table += 1;
+                if (const auto result = callback(tableRef); result.hasFailed()) {
+                    // Errors can't be thrown through the pipeline, the system is disabled
+                    // and the error is stored in the system entity instead
+                    it.system().set<LuaError>({ std::format("{} disabled : {}", profileName, result.errorMessage()) });
+                    it.system().disable();
+                    it.fini();
+                    return;
+                }
+            }
+        });
+        system.add<LuaSystem>();
+        return system;
+    }
+
+    // The entities read from Lua can be destroyed entities, flecs asserts on most operations on them
+    static const flecs::entity& checkAlive(const flecs::entity& e) {
+        if (!e.is_alive()) {
+            throw std::invalid_argument(std::format("Entity {} is not alive", e.id()));
+        }
+        return e;
+    }
+
+    // Calls a function taking an entity after checking that the entity is alive
+    template <auto Function>
+    struct AliveEntity;
+
+    template <typename R, typename... Args, R (*Function)(const flecs::entity&, Args...)>
+    struct AliveEntity<Function> {
+        static R call(const flecs::entity& e, Args... args) {
+            return Function(checkAlive(e), std::forward<Args>(args)...);
+        }
+    };
+
+    // The synchronous loads create the nodes immediately, the systems and the behaviors
+    // run in the pipeline on a read-only world
+    static void checkSynchronousLoad(const flecs::entity& root) {
+        if (root.world().is_readonly()) {
+            throw std::logic_error("Synchronous load from a system or a behavior, use load_async");
+        }
+    }
+
+    // Returns the index of a 1-based row of a system table
+    static size_t checkRow(const LuaSystemTable* table, const int32 row) {
+        const auto& it = table->getIter();
+        if (row < 1 || row > it.count()) {
+            throw std::out_of_range(std::format(
+                "Row {} out of the system table, 1 to {} expected", row, it.count()));
+        }
+        return static_cast<size_t>(row - 1);
+    }
+
+    // Reads a Lua array of entities
+    static std::vector<flecs::entity> toEntities(const luabridge::LuaRef& table) {
+        auto entities = std::vector<flecs::entity>{};
+        const auto count = table.length();
+        entities.reserve(count);
+        for (auto i = 1; i <= count; ++i) {
+            const auto e = table[i].cast<flecs::entity>();
+            if (!e) {
+                throw std::invalid_argument(std::format("Not an entity at index {}", i));
+            }
+            entities.push_back(checkAlive(*e));
+        }
+        return entities;
+    }
+
+    // Reads a Lua array of float3 or a flat Lua array of numbers x1, y1, z1, x2, ...
+    static std::vector<float3> toFloat3s(const luabridge::LuaRef& table) {
+        auto vectors = std::vector<float3>{};
+        const auto count = table.length();
+        if (count == 0) { return vectors; }
+        if (table[1].isNumber()) {
+            if (count % 3 != 0) {
+                throw std::invalid_argument("Flat array of vectors with a length not multiple of 3");
+            }
+            vectors.reserve(count / 3);
+            for (auto i = 1; i + 2 <= count; i += 3) {
+                vectors.push_back({
+                    table[i].unsafe_cast<float>(),
+                    table[i + 1].unsafe_cast<float>(),
+                    table[i + 2].unsafe_cast<float>()});
+            }
+        } else {
+            vectors.reserve(count);
+            for (auto i = 1; i <= count; ++i) {
+                vectors.push_back(table[i].unsafe_cast<float3>());
+            }
+        }
+        return vectors;
+    }
+
+    // The per-entity wrappers only assert the lengths, the Lua callers get an error instead
+    static void checkLengths(const std::vector<flecs::entity>& entities, const std::vector<float3>& vectors) {
+        if (entities.size() != vectors.size()) {
+            throw std::invalid_argument(std::format(
+                "{} entities for {} vectors, one vector per entity expected", entities.size(), vectors.size()));
+        }
+    }
+
+    void LuaBindings::_unregister(const flecs::world& world) {
+        // The behaviors and the callbacks of the systems hold references to the Lua state
+        world.get_mut<LuaScheduler>() = LuaScheduler{};
+        world.delete_with<LuaSystem>();
+    }
+
+    void LuaBindings::_register(const lysa::Lua& lua, const flecs::world& world) {
+        luaWorld = world.c_ptr();
+        luaDeferredCommands = world.get<ECSConfiguration>().luaDeferredCommands;
+        world.set<LuaScheduler>({});
+        world.set<LuaReflectedComponents>({});
+        world.observer()
+            .with<LuaBehavior>()
+            .event(flecs::OnRemove)
+            .run(profileRun("LuaBindings.OnRemove(LuaBehavior)"), [](const flecs::entity e) {
+                e.world().get_mut<LuaScheduler>().stop(e.id());
+            });
+        world.system("LuaBehaviors")
+            .kind(flecs::OnUpdate)
+            .run([](flecs::iter& it) {
+                const auto profile = ProfilerScope{"LuaBindings.behaviors"};
+                const auto w = it.world();
+                w.get_mut<LuaScheduler>().update(
+                    w,
+                    it.delta_time(),
+                    std::chrono::microseconds{w.get<ECSConfiguration>().luaBehaviorsBudget});
+            });
         lua.beginNamespace("ecs")
             .beginClass<RenderTarget>("RenderTarget")
                 .addConstructor<void(unique_id)>()
                 .addProperty("render_target", &RenderTarget::renderTarget)
+                .addProperty("component_id", &LuaComponents::getId<RenderTarget>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<RenderTarget>)
             .endClass()
             .beginClass<Viewport>("Viewport")
                 .addConstructor<void(), void(vireo::Viewport), void(vireo::Viewport, vireo::Rect)>()
                 .addProperty("viewport", &Viewport::viewport)
                 .addProperty("scissors", &Viewport::scissors)
+                .addProperty("component_id", &LuaComponents::getId<Viewport>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<Viewport>)
             .endClass()
             .beginClass<Camera>("Camera")
                 .addConstructor<void()>()
@@ -34,67 +1352,207 @@ namespace lysa::ecs {
                 .addProperty("right", &Camera::right)
                 .addProperty("top", &Camera::top)
                 .addProperty("bottom", &Camera::bottom)
+                .addProperty("component_id", &LuaComponents::getId<Camera>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<Camera>)
             .endClass()
             .beginClass<CameraRef>("CameraRef")
                 .addConstructor<void(flecs::entity)>()
                 .addProperty("camera", &CameraRef::camera)
+                .addProperty("component_id", &LuaComponents::getId<CameraRef>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<CameraRef>)
             .endClass()
             .beginClass<MaterialOverride>("MaterialOverride")
                 .addConstructor<void(), void(uint32, unique_id)>()
                 .addProperty("surface_index", &MaterialOverride::surfaceIndex)
                 .addProperty("material", &MaterialOverride::material)
+                .addProperty("component_id", &LuaComponents::getId<MaterialOverride>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<MaterialOverride>)
             .endClass()
             .beginClass<MeshInstance>("MeshInstance")
                 .addConstructor<void(unique_id)>()
-                .addProperty("mesh", &MeshInstance::mesh_instance)
+                .addProperty("mesh", &MeshInstance::mesh)
+                .addProperty("mesh_instance", +[](const MeshInstance* meshInstance) {
+                    return meshInstance->mesh_instance;
+                })
+                .addProperty("component_id", &LuaComponents::getId<MeshInstance>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<MeshInstance>)
             .endClass()
             .beginClass<Scene>("Scene")
                 .addConstructor<void()>()
                 .addProperty("scene", &Scene::context)
+                .addProperty("component_id", &LuaComponents::getId<Scene>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<Scene>)
             .endClass()
             .beginClass<SceneRef>("SceneRef")
                 .addConstructor<void(flecs::entity)>()
                 .addProperty("scene", &SceneRef::scene)
+                .addProperty("component_id", &LuaComponents::getId<SceneRef>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<SceneRef>)
             .endClass()
             .beginClass<AmbientLight>("AmbientLight")
                 .addConstructor<void()>()
                 .addProperty("color", &AmbientLight::color)
                 .addProperty("intensity", &AmbientLight::intensity)
+                .addProperty("component_id", &LuaComponents::getId<AmbientLight>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<AmbientLight>)
             .endClass()
             .beginClass<Visible>("Visible")
                 .addConstructor<void()>()
+                .addProperty("component_id", &LuaComponents::getId<Visible>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<Visible>)
             .endClass()
             .beginClass<Transform>("Transform")
                 .addConstructor<void()>()
                 .addProperty("local", &Transform::local)
                 .addProperty("global", &Transform::global)
+                .addProperty("component_id", &LuaComponents::getId<Transform>)
+                .addStaticProperty("component_id", &LuaComponents::componentId<Transform>)
             .endClass()
 
             .addFunction("set_position",
-                luabridge::overload<const flecs::entity&, const float3&>(&setPosition),
-                luabridge::overload<const flecs::entity&, float, float, float>(&setPosition)
+                luabridge::overload<const flecs::entity&, const float3&>(
+                    &AliveEntity<static_cast<void (*)(const flecs::entity&, const float3&)>(&setPosition)>::call),
+                luabridge::overload<const flecs::entity&, float, float, float>(
+                    &AliveEntity<static_cast<void (*)(const flecs::entity&, float, float, float)>(&setPosition)>::call)
             )
             .addFunction("translate",
-                luabridge::overload<const flecs::entity&, const float3&>(&translate),
-                luabridge::overload<const flecs::entity&, float, float, float>(&translate)
+                luabridge::overload<const flecs::entity&, const float3&>(
+                    &AliveEntity<static_cast<void (*)(const flecs::entity&, const float3&)>(&translate)>::call),
+                luabridge::overload<const flecs::entity&, float, float, float>(
+                    &AliveEntity<static_cast<void (*)(const flecs::entity&, float, float, float)>(&translate)>::call)
+            )
+            .addFunction("get_positions", +[](const luabridge::LuaRef& entities) {
+                auto positions = luabridge::newTable(entities.state());
+                auto index = 1;
+                for (const auto& position : getPositions(toEntities(entities))) {
+                    positions[index++] = static_cast<float>(position.x);
+                    positions[index++] = static_cast<float>(position.y);
+                    positions[index++] = static_cast<float>(position.z);
+                }
+                return positions;
+            })
+            .addFunction("set_positions", +[](const luabridge::LuaRef& entities, const luabridge::LuaRef& positions) {
+                const auto e = toEntities(entities);
+                const auto p = toFloat3s(positions);
+                checkLengths(e, p);
+                setPositions(e, p);
+            })
+            .addFunction("translate_many",
+                luabridge::overload<const luabridge::LuaRef&, const float3&>(+[](const luabridge::LuaRef& entities, const float3& localOffset) {
+                    translate(toEntities(entities), localOffset);
+                }),
+                luabridge::overload<const luabridge::LuaRef&, const luabridge::LuaRef&>(+[](const luabridge::LuaRef& entities, const luabridge::LuaRef& localOffsets) {
+                    const auto e = toEntities(entities);
+                    const auto offsets = toFloat3s(localOffsets);
+                    checkLengths(e, offsets);
+                    translate(e, offsets);
+                })
             )
             .addFunction("scale",
-                luabridge::overload<const flecs::entity&, const float&>(&scale)
+                luabridge::overload<const flecs::entity&, const float&>(&AliveEntity<&scale>::call)
             )
-            .addFunction("rotate_x",&rotateX)
-            .addFunction("rotate_y",&rotateY)
-            .addFunction("rotate_z",&rotateZ)
-            .addFunction("set_rotation_x",&setRotationX)
-            .addFunction("set_rotation_y",&setRotationY)
-            .addFunction("set_rotation_z",&setRotationZ)
-            .addFunction("get_rotation_x",&getRotationX)
-            .addFunction("get_rotation_y",&getRotationY)
-            .addFunction("get_rotation_z",&getRotationZ)
-
-            .addFunction("load",
-                luabridge::overload<flecs::entity&, const std::string&>(&load)
+            .addFunction("rotate_x", &AliveEntity<&rotateX>::call)
+            .addFunction("rotate_y", &AliveEntity<&rotateY>::call)
+            .addFunction("rotate_z", &AliveEntity<&rotateZ>::call)
+            .addFunction("set_rotation_x", &AliveEntity<&setRotationX>::call)
+            .addFunction("set_rotation_y", &AliveEntity<&setRotationY>::call)
+            .addFunction("set_rotation_z", &AliveEntity<&setRotationZ>::call)
+            .addFunction("get_rotation_x", &AliveEntity<&getRotationX>::call)
+            .addFunction("get_rotation_y", &AliveEntity<&getRotationY>::call)
+            .addFunction("get_rotation_z", &AliveEntity<&getRotationZ>::call)
+
+            .addFunction("load", +[](flecs::entity root, const std::string& uri) {
+                checkAlive(root);
+                checkSynchronousLoad(root);
+                return load(root, uri);
+            })
+            .addFunction("instantiate", +[](flecs::entity root, const std::string& uri) {
+                checkAlive(root);
+                checkSynchronousLoad(root);
+                return instantiate(root, uri);
+            })
+            .beginClass<AsyncLoad>("AsyncLoad")
+                .addProperty("is_loaded", &AsyncLoad::isLoaded)
+                .addProperty("is_failed", &AsyncLoad::isFailed)
+                .addProperty("error", &AsyncLoad::getError)
+                .addProperty("progress", &AsyncLoad::getProgress)
+                .addProperty("root", &AsyncLoad::getRoot)
+            .endClass()
+            .addFunction("load_async",
+                luabridge::overload<const flecs::entity&, const std::string&>(
+                    &AliveEntity<static_cast<std::shared_ptr<AsyncLoad> (*)(const flecs::entity&, const std::string&)>(&loadAsync)>::call)
             )
+            .addFunction("wait", &luaWait)
+            .addFunction("wait_event", &luaWaitEvent)
+            .addFunction("emit", +[](const std::string& event) {
+                flecs::world(luaWorld).get_mut<LuaScheduler>().emit(event);
+            })
+            .addFunction("set_profiling", +[](const bool enabled, lua_State* L) {
+                LuaProfiler::setEnabled(L, enabled);
+            })
+            .addFunction("get_native_calls", +[] {
+                return LuaBindings::getNativeCalls();
+            })
 
+            .beginClass<LuaComponentView<Transform>>("TransformView")
+                .addProperty("is_valid", &LuaComponentView<Transform>::isValid)
+                .addProperty("entity", &LuaComponentView<Transform>::getEntity)
+                .addProperty("local",
+                    +[](const LuaComponentView<Transform>* v) -> const float4x4& {
+                        return v->get().local;
+                    },
+                    +[](LuaComponentView<Transform>* v, const float4x4& local) {
+                        v->get().local = local;
+                        v->getEntity().add<TransformUpdated>();
+                    })
+                .addProperty("global", +[](const LuaComponentView<Transform>* v) -> const float4x4& {
+                    return v->get().global;
+                })
+                .addProperty("x",
+                    +[](const LuaComponentView<Transform>* v) -> float { return v->get().local[3].x; },
+                    +[](LuaComponentView<Transform>* v, const float x) {
+                        v->get().local[3].x = x;
+                        v->getEntity().add<TransformUpdated>();
+                    })
+                .addProperty("y",
+                    +[](const LuaComponentView<Transform>* v) -> float { return v->get().local[3].y; },
+                    +[](LuaComponentView<Transform>* v, const float y) {
+                        v->get().local[3].y = y;
+                        v->getEntity().add<TransformUpdated>();
+                    })
+                .addProperty("z",
+                    +[](const LuaComponentView<Transform>* v) -> float { return v->get().local[3].z; },
+                    +[](LuaComponentView<Transform>* v, const float z) {
+                        v->get().local[3].z = z;
+                        v->getEntity().add<TransformUpdated>();
+                    })
+            .endClass()
+            .beginClass<LuaQueryRow>("QueryRow")
+                .addProperty("entity", +[](const LuaQueryRow* row) {
+                    return row->getIter().entity(row->cursor->index);
+                })
+                .addFunction("get", +[](LuaQueryRow* row, const luabridge::LuaRef& component) {
+                    return LuaComponents::get(*row, component);
+                })
+            .endClass()
+            .beginClass<LuaSystemTable>("SystemTable")
+                .addProperty("count", +[](const LuaSystemTable* table) {
+                    return static_cast<int32>(table->getIter().count());
+                })
+                .addProperty("delta_time", +[](const LuaSystemTable* table) {
+                    return table->getIter().delta_system_time();
+                })
+                .addFunction("entity", +[](const LuaSystemTable* table, const int32 row) {
+                    return table->getIter().entity(checkRow(table, row));
+                })
+                .addFunction("get", +[](LuaSystemTable* table, const luabridge::LuaRef& component, const int32 row) {
+                    return LuaComponents::get(*table, component, checkRow(table, row));
+                })
+            .endClass()
+            .beginClass<LuaQuery>("Query")
+                .addProperty("count", &LuaQuery::count)
+                .addFunction("each", &LuaQuery::each)
+            .endClass()
             .beginClass<flecs::world>("world")
                 .addFunction("entity",
                     luabridge::overload<const flecs::world*>(+[](const flecs::world* w) {
@@ -104,6 +1562,12 @@ namespace lysa::ecs {
                         return w->entity<>(name);
                     })
                 )
+                .addFunction("query", +[](const flecs::world* w, const luabridge::LuaRef& components) {
+                    return LuaQuery{*w, components};
+                })
+                .addFunction("system", +[](const flecs::world* w, const luabridge::LuaRef& desc) {
+                    return createSystem(*w, desc);
+                })
                 .addFunction("prefab",
                     luabridge::overload<const flecs::world*>(+[](const flecs::world* w) {
                         return w->prefab<>();
@@ -116,174 +1580,137 @@ namespace lysa::ecs {
             .addProperty("child_of", +[]{ return flecs::ChildOf;})
             .addProperty("is_a", +[]{ return flecs::IsA;})
 
-            .beginClass<flecs::entity>("entity")
-                .addProperty("is_alive", +[](const flecs::entity* e) { return e->is_alive(); })
-                .addFunction("destruct", &flecs::entity::destruct)
-                .addFunction("is_a",
-                    luabridge::overload<const flecs::entity*, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity s) {
-                        return e->is_a(s);
-                    })
-                )
-                .addFunction("child_of", +[](const flecs::entity* e, const flecs::entity& p) {
-                    return e->add(flecs::ChildOf, p);
+            .beginNamespace("entity")
+                .addFunction("view", +[](lua_State* L) {
+                    try {
+                        const auto e = luabridge::Stack<flecs::entity>::get(L, 1);
+                        if (!e) {
+                            throw std::invalid_argument("entity:view() called without an entity");
+                        }
+                        const auto component = luabridge::LuaRef::fromStack(L, 2);
+                        return LuaReflectedView::push(L, checkAlive(*e), LuaComponents::getComponent(e->world(), component));
+                    } catch (const std::exception& error) {
+                        lua_pushstring(L, error.what());
+                    }
+                    // Raised once the exception is destroyed, lua_error does not return
+                    return lua_error(L);
+                })
+                .addFunction("start_behavior", +[](const flecs::entity e, const luabridge::LuaRef& function) {
+                    e.world().get_mut<LuaScheduler>().start(checkAlive(e), function);
+                })
+                .addFunction("stop_behavior", +[](const flecs::entity e) {
+                    e.world().get_mut<LuaScheduler>().requestStop(checkAlive(e));
+                })
+                .addFunction("destruct", +[](const flecs::entity e) {
+                    if (luaDeferredCommands) {
+                        luaCommands.push({ .entity = e.id(), .type = LuaCommand::Type::Destruct });
+                        return;
+                    }
+                    e.destruct();
+                })
+                .addFunction("is_a", +[](const flecs::entity e, const flecs::entity s) {
+                    return checkAlive(e).is_a(checkAlive(s));
+                })
+                .addFunction("child_of", +[](const flecs::entity e, const flecs::entity p) {
+                    return add(checkAlive(e), flecs::ChildOf, checkAlive(p));
+                })
+                .addFunction("load", +[](flecs::entity e, const std::string& uri) {
+                    checkAlive(e);
+                    checkSynchronousLoad(e);
+                    return load(e, uri);
+                })
+                .addFunction("load_async", +[](const flecs::entity e, const std::string& uri) {
+                    return loadAsync(checkAlive(e), uri);
+                })
+                .addFunction("instantiate", +[](flecs::entity e, const std::string& uri) {
+                    checkAlive(e);
+                    checkSynchronousLoad(e);
+                    return instantiate(e, uri);
                 })
-                .addFunction("load",
-                    luabridge::overload<flecs::entity*, const std::string&>(&load)
-                )
                 .addFunction("add",
-                    luabridge::overload<const flecs::entity*, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity c) {
-                       return e->set(c);
-                    }),
-                    luabridge::overload<const flecs::entity*, const flecs::entity, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity f, const flecs::entity s) {
-                      return e->add(f, s);
-                    }),
-                    luabridge::overload<const flecs::entity*, const flecs::entity_t, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity_t f, const flecs::entity s) {
-                      return e->add(f, s);
-                    }),
-                    luabridge::overload<const flecs::entity*, const RenderTarget&>(+[](const flecs::entity* e, const RenderTarget& p) {
-                        return e->set<RenderTarget>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const Viewport&>(+[](const flecs::entity* e, const Viewport& p) {
-                        return e->set<Viewport>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const Camera&>(+[](const flecs::entity* e, const Camera& p) {
-                        return e->set<Camera>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const CameraRef&>(+[](const flecs::entity* e, const CameraRef& p) {
-                        return e->set<CameraRef>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const MaterialOverride&>(+[](const flecs::entity* e, const MaterialOverride& p) {
-                        return e->set<MaterialOverride>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const MeshInstance&>(+[](const flecs::entity* e, const MeshInstance& p) {
-                        return e->set<MeshInstance>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const Scene&>(+[](const flecs::entity* e, const Scene&) {
-                        return e->add<Scene>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const SceneRef&>(+[](const flecs::entity* e, const SceneRef& p) {
-                        return e->set<SceneRef>(p);
-                    }),
-                    luabridge::overload<const flecs::entity*, const AmbientLight&>(+[](const flecs::entity* e, const AmbientLight& p) {
-                        return e->set<AmbientLight>(p);
+                    luabridge::overload<const flecs::entity, const luabridge::LuaRef&>(+[](const flecs::entity e, const luabridge::LuaRef& c) {
+                        checkAlive(e);
+                        if (c.isInstance<flecs::entity>()) {
+                            return add(e, checkAlive(c.unsafe_cast<flecs::entity>()));
+                        }
+                        if (luaDeferredCommands) {
+                            luaCommands.push(LuaComponents::addCommand(e, c));
+                            return e;
+                        }
+                        return LuaComponents::add(e, c);
                     }),
-                    luabridge::overload<const flecs::entity*, const Visible&>(+[](const flecs::entity* e, const Visible&) {
-                        return e->add<Visible>();
+                    luabridge::overload<const flecs::entity, const flecs::entity, const flecs::entity>(+[](const flecs::entity e, const flecs::entity f, const flecs::entity s) {
+                      return add(checkAlive(e), checkAlive(f), checkAlive(s));
                     }),
-                    luabridge::overload<const flecs::entity*, const Transform&>(+[](const flecs::entity* e, const Transform& p) {
-                        return e->set<Transform>(p);
-                    })
-                    )
-                .addFunction("has",
-                    luabridge::overload<const flecs::entity*, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity c) {
-                       return e->has(c);
-                   }),
-                   luabridge::overload<const flecs::entity*, const RenderTarget&>(+[](const flecs::entity* e, const RenderTarget& p) {
-                        return e->has<RenderTarget>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Viewport&>(+[](const flecs::entity* e, const Viewport& p) {
-                        return e->has<Viewport>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Camera&>(+[](const flecs::entity* e, const Camera& p) {
-                        return e->has<Camera>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const CameraRef&>(+[](const flecs::entity* e, const CameraRef& p) {
-                        return e->has<CameraRef>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const MaterialOverride&>(+[](const flecs::entity* e, const MaterialOverride& p) {
-                        return e->has<MaterialOverride>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const MeshInstance&>(+[](const flecs::entity* e, const MeshInstance& p) {
-                        return e->has<MeshInstance>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Scene&>(+[](const flecs::entity* e, const Scene& p) {
-                        return e->has<Scene>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const SceneRef&>(+[](const flecs::entity* e, const SceneRef& p) {
-                        return e->has<SceneRef>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const AmbientLight&>(+[](const flecs::entity* e, const AmbientLight& p) {
-                        return e->has<AmbientLight>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Visible&>(+[](const flecs::entity* e, const Visible&) {
-                        return e->has<Visible>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Transform&>(+[](const flecs::entity* e, const Transform& p) {
-                        return e->has<Transform>();
+                    luabridge::overload<const flecs::entity, const flecs::entity_t, const flecs::entity>(+[](const flecs::entity e, const flecs::entity_t f, const flecs::entity s) {
+                      return add(checkAlive(e), f, checkAlive(s));
                     })
                 )
+                .addFunction("has", +[](const flecs::entity e, const luabridge::LuaRef& c) {
+                    checkAlive(e);
+                    if (c.isInstance<flecs::entity>()) {
+                        return e.has(checkAlive(c.unsafe_cast<flecs::entity>()));
+                    }
+                    return LuaComponents::has(e, c);
+                })
                 .addFunction("remove",
-                     luabridge::overload<const flecs::entity*, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity c) {
-                        return e->remove(c);
-                    }),
-                    luabridge::overload<const flecs::entity*, const flecs::entity, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity f, const flecs::entity s) {
-                       return e->remove(f, s);
-                    }),
-                    luabridge::overload<const flecs::entity*, const flecs::entity_t, const flecs::entity>(+[](const flecs::entity* e, const flecs::entity_t f, const flecs::entity s) {
-                       return e->remove(f, s);
+                    luabridge::overload<const flecs::entity, const luabridge::LuaRef&>(+[](const flecs::entity e, const luabridge::LuaRef& c) {
+                        checkAlive(e);
+                        if (c.isInstance<flecs::entity>()) {
+                            return remove(e, c.unsafe_cast<flecs::entity>().id());
+                        }
+                        if (luaDeferredCommands) {
+                            return remove(e, LuaComponents::getComponent(e.world(), c));
+                        }
+                        return LuaComponents::remove(e, c);
                     }),
-                    luabridge::overload<const flecs::entity*, const RenderTarget&>(+[](const flecs::entity* e, const RenderTarget& p) {
-                        return e->remove<RenderTarget>();
+                    luabridge::overload<const flecs::entity, const flecs::entity, const flecs::entity>(+[](const flecs::entity e, const flecs::entity f, const flecs::entity s) {
+                       return remove(checkAlive(e), e.world().pair(f, s));
                     }),
-                    luabridge::overload<const flecs::entity*, const Viewport&>(+[](const flecs::entity* e, const Viewport& p) {
-                        return e->remove<Viewport>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Camera&>(+[](const flecs::entity* e, const Camera& p) {
-                        return e->remove<Camera>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const CameraRef&>(+[](const flecs::entity* e, const CameraRef& p) {
-                        return e->remove<CameraRef>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const MaterialOverride&>(+[](const flecs::entity* e, const MaterialOverride& p) {
-                        return e->remove<MaterialOverride>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const MeshInstance&>(+[](const flecs::entity* e, const MeshInstance& p) {
-                        return e->remove<MeshInstance>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Scene&>(+[](const flecs::entity* e, const Scene& p) {
-                        return e->remove<Scene>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const SceneRef&>(+[](const flecs::entity* e, const SceneRef& p) {
-                        return e->remove<SceneRef>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const AmbientLight&>(+[](const flecs::entity* e, const AmbientLight& p) {
-                        return e->remove<AmbientLight>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Visible&>(+[](const flecs::entity* e, const Visible&) {
-                        return e->remove<Visible>();
-                    }),
-                    luabridge::overload<const flecs::entity*, const Transform&>(+[](const flecs::entity* e, const Transform& p) {
-                        return e->remove<Transform>();
+                    luabridge::overload<const flecs::entity, const flecs::entity_t, const flecs::entity>(+[](const flecs::entity e, const flecs::entity_t f, const flecs::entity s) {
+                       return remove(checkAlive(e), e.world().pair(f, s));
                     })
                 )
-                .addProperty("render_target", [](const flecs::entity* e) -> const RenderTarget& {
-                    return e->get<RenderTarget>();
+            .endNamespace()
+            // Getters of the entity properties, called by the __index of the entities
+            .beginNamespace("entity_properties")
+                .addFunction("id", +[](const flecs::entity e) {
+                    return e.id();
                 })
-                .addProperty("viewport", [](const flecs::entity* e) -> const Viewport& {
-                    return e->get<Viewport>();
+                .addFunction("is_alive", +[](const flecs::entity e) {
+                    return e.is_alive();
                 })
-                .addProperty("camera", [](const flecs::entity* e) -> Camera& {
-                    return e->get_mut<Camera>();
+                .addFunction("render_target", +[](const flecs::entity e) -> const RenderTarget& {
+                    return checkAlive(e).get<RenderTarget>();
                 })
-                .addProperty("camera_ref", [](const flecs::entity* e) -> const CameraRef& {
-                    return e->get<CameraRef>();
+                .addFunction("viewport", +[](const flecs::entity e) -> const Viewport& {
+                    return checkAlive(e).get<Viewport>();
                 })
-                .addProperty("material_override", [](const flecs::entity* e) -> const MaterialOverride& {
-                    return e->get<MaterialOverride>();
+                .addFunction("camera", +[](const flecs::entity e) -> Camera& {
+                    return checkAlive(e).get_mut<Camera>();
                 })
-                .addProperty("mesh_instance", [](const flecs::entity* e) -> const MeshInstance& {
-                    return e->get<MeshInstance>();
+                .addFunction("camera_ref", +[](const flecs::entity e) -> const CameraRef& {
+                    return checkAlive(e).get<CameraRef>();
                 })
-                .addProperty("scene_ref", [](const flecs::entity* e) -> const SceneRef& {
-                    return e->get<SceneRef>();
+                .addFunction("material_override", +[](const flecs::entity e) -> const MaterialOverride& {
+                    return checkAlive(e).get<MaterialOverride>();
                 })
-                .addProperty("ambient_light", [](const flecs::entity* e) -> const AmbientLight& {
-                    return e->get<AmbientLight>();
+                .addFunction("mesh_instance", +[](const flecs::entity e) -> const MeshInstance& {
+                    return checkAlive(e).get<MeshInstance>();
                 })
-                .addProperty("transform", [](const flecs::entity* e) -> const Transform& {
-                    return e->get<Transform>();
+                .addFunction("scene_ref", +[](const flecs::entity e) -> const SceneRef& {
+                    return checkAlive(e).get<SceneRef>();
                 })
-            .endClass()
+                .addFunction("ambient_light", +[](const flecs::entity e) -> const AmbientLight& {
+                    return checkAlive(e).get<AmbientLight>();
+                })
+                .addFunction("transform", +[](const flecs::entity e) -> const Transform& {
+                    return checkAlive(e).get<Transform>();
+                })
+                .addFunction("transform_view", +[](const flecs::entity e) {
+                    return LuaComponentView<Transform>{checkAlive(e)};
+                })
+            .endNamespace()
         .endNamespace();
     }
 
@@ -6,12 +6,45 @@
 */
 export module lysa.ecs.lua;
 
+import std;
 import lysa.lua;
+import lysa.types;
+import lysa.ecs.flecs;
 
 export namespace lysa::ecs {
 
+    /**
+     * Error that stopped a Lua system or behavior, set on the disabled system entity
+     * or on the entity of the behavior. Starting a new behavior removes it
+     */
+    struct LuaError {
+        std::string message;
+    };
+
     struct LuaBindings {
-        static void _register(const Lua& lua);
+        /**
+         * Registers the ECS classes and functions.
+         * The entities are passed to Lua as ids and resolved in the world given here
+         */
+        static void _register(const Lua& lua, const flecs::world& world);
+
+        /**
+         * Stops the behaviors and destroys the systems defined in Lua.
+         * Called by the ecs destructor, must be called before the Lua state is destroyed
+         * if the world outlives it
+         */
+        static void _unregister(const flecs::world& world);
+
+        /**
+         * Applies the structural changes queued from Lua, called by ecs::progress()
+         */
+        static void mergeCommands(const flecs::world& world);
+
+        /**
+         * Returns the number of calls from Lua to the native functions during a frame,
+         * by default the last completed frame. Requires ECS_PROFILER and ecs.set_profiling(true)
+         */
+        static uint64 getNativeCalls(uint64 frame = 0);
     };
 
 }
\ No newline at end of file
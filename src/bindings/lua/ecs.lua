@@ -28,7 +28,8 @@ return {
     CameraRef = ecs.CameraRef,
 
     ---@class MaterialOverride
-    ---@field mesh integer
+    ---@field surface_index integer
+    ---@field material integer
     MaterialOverride = ecs.MaterialOverride,
 
     ---@class Scene
@@ -40,8 +41,8 @@ return {
     SceneRef = ecs.SceneRef,
 
     ---@class MeshInstance
-    ---@field surface_index integer
-    ---@field material integer
+    ---@field mesh integer
+    ---@field mesh_instance integer read only, created by the ECS
     MeshInstance = ecs.MeshInstance,
 
     ---@class Visible
@@ -61,11 +62,20 @@ return {
     ---@field scene ecs.Scene
     SceneRef = ecs.SceneRef,
 
+    ---Entities are light userdata holding the entity id : passing them around allocates nothing
+    ---and two handles of the same entity are equal.
+    ---With ECSConfiguration::luaDeferredCommands the add, remove, child_of and destruct calls are queued
+    ---and applied at the start of the next frame : has() and the properties don't see the pending changes
     ---@class ecs.entity
+    ---@field id integer
+    ---@field start_behavior fun(self:ecs.entity, behavior:fun(e:ecs.entity)):nil runs the function as a coroutine resumed by the ECS, see ecs.wait. An error stops the behavior and is stored in the LuaError component of the entity
+    ---@field stop_behavior fun(self:ecs.entity):nil
     ---@field is_alive boolean
     ---@field destruct fun(self:ecs.entity):nil
     ---@field is_a fun(self:ecs.entity):nil
-    ---@overload load fun(self:ecs.entity,uri:string):ecs:entity
+    ---@overload load fun(self:ecs.entity,uri:string):ecs:entity not allowed from a system or a behavior, use load_async
+    ---@overload load_async fun(self:ecs.entity,uri:string):ecs.AsyncLoad
+    ---@overload instantiate fun(self:ecs.entity,uri:string):ecs:entity not allowed from a system or a behavior
     ---@field add fun(self:ecs.entity):ecs:entity
     ---@field remove fun(self:ecs.entity, e:ecs.entity):ecs:entity
     ---@field remove fun(self:ecs.entity, self:ecs.entity):ecs:entity
@@ -81,8 +91,29 @@ return {
     ---@field ambient_light  ecs.AmbientLight
     ---@field visible  ecs.Visible
     ---@field transform  ecs.Transform
+    ---@field transform_view  ecs.TransformView
+    ---@field view fun(self:ecs.entity, component:table):ecs.ComponentView view on a component described with flecs meta
     entity = ecs.entity,
 
+    ---View reading and writing the Transform in place, keep it instead of reading e.transform each time
+    ---@class ecs.TransformView
+    ---@field is_valid boolean
+    ---@field entity ecs.entity
+    ---@field local lysa.float4x4
+    ---@field global lysa.float4x4
+    ---@field x number local position
+    ---@field y number local position
+    ---@field z number local position
+    TransformView = ecs.TransformView,
+
+    ---View reading and writing a component in place, the fields are the bool, number and entity members
+    ---of its flecs meta description. Writing a field runs the OnSet observers of the component.
+    ---The views of Camera, MaterialOverride and RenderTarget have all the fields of the component class,
+    ---the vector and string members of AmbientLight and StreamingCell are only reachable from the class
+    ---@class ecs.ComponentView
+    ---@field is_valid boolean
+    ---@field entity ecs.entity
+
     ---@overload fun(e:ecs.entity, p:lysa.float3)
     ---@overload fun(e:ecs.entity, x:float,y:float,z:float)
     set_position = ecs.set_position,
@@ -91,6 +122,19 @@ return {
     ---@overload fun(e:ecs.entity, x:float,y:float,z:float)
     translate = ecs.translate,
 
+    ---Returns the local positions as a flat array x1, y1, z1, x2, ...
+    ---@param entities ecs.entity[]
+    ---@return number[]
+    get_positions = ecs.get_positions,
+
+    ---@param entities ecs.entity[]
+    ---@param positions lysa.float3[]|number[] float3 or flat x, y, z numbers, one position per entity
+    set_positions = ecs.set_positions,
+
+    ---@overload fun(entities:ecs.entity[], offset:lysa.float3)
+    ---@overload fun(entities:ecs.entity[], offsets:lysa.float3[]|number[])
+    translate_many = ecs.translate_many,
+
     ---@overload fun(e:ecs.entity, scale:float)
     scale = ecs.scale,
 
@@ -130,14 +174,81 @@ return {
     ---@return number
     get_rotation_z = ecs.get_rotation_z,
 
+    ---Not allowed from a system or a behavior, use load_async
     ---@param e ecs.entity
     ---@param uri string
     load = ecs.load,
 
+    ---Not allowed from a system or a behavior
+    ---@param e ecs.entity
+    ---@param uri string
+    instantiate = ecs.instantiate,
+
+    ---@class ecs.AsyncLoad
+    ---@field is_loaded boolean
+    ---@field is_failed boolean
+    ---@field error string
+    ---@field progress number
+    ---@field root ecs.entity
+    AsyncLoad = ecs.AsyncLoad,
+
+    ---@param e ecs.entity
+    ---@param uri string
+    ---@return ecs.AsyncLoad
+    load_async = ecs.load_async,
+
+    ---Yields the running behavior for a number of seconds
+    ---@param seconds number
+    wait = ecs.wait,
+
+    ---Yields the running behavior until the event is emitted
+    ---@param event string
+    wait_event = ecs.wait_event,
+
+    ---Resumes the behaviors waiting for the event at the next frame
+    ---@param event string
+    emit = ecs.emit,
+
+    ---Records the Lua functions and the native calls in the ECS profiler, requires a build with ECS_PROFILER
+    ---@param enabled boolean
+    set_profiling = ecs.set_profiling,
+
+    ---Returns the number of calls from Lua to native functions during the last frame
+    ---@return integer
+    get_native_calls = ecs.get_native_calls,
+
     ---@return ecs.entity
     child_of = ecs.child_of,
 
+    ---Row of a query iteration, valid until each() returns
+    ---@class ecs.QueryRow
+    ---@field entity ecs.entity
+    ---@field get fun(self:ecs.QueryRow, component:table):any view on the component of the row, following the current row, true or false for the tags, nil if the entity does not have the component
+    QueryRow = ecs.QueryRow,
+
+    ---@class ecs.Query
+    ---@field count integer
+    ---@field each fun(self:ecs.Query, callback:fun(row:ecs.QueryRow))
+    Query = ecs.Query,
+
+    ---Table of a system run, valid until the run function returns
+    ---@class ecs.SystemTable
+    ---@field count integer number of entities in the table
+    ---@field delta_time number time since the last run of the system
+    ---@field entity fun(self:ecs.SystemTable, row:integer):ecs.entity
+    ---@field get fun(self:ecs.SystemTable, component:table, row:integer):any view on the component of the row, valid while the system is on this table, true or false for the tags, nil if the table does not have the component
+    SystemTable = ecs.SystemTable,
+
+    ---@class ecs.SystemDesc
+    ---@field name string|nil
+    ---@field query table[] component classes
+    ---@field phase string|nil OnLoad, PostLoad, PreUpdate, OnUpdate (default), OnValidate, PostUpdate, PreStore, OnStore, FixedUpdate or FixedPostUpdate
+    ---@field interval number|nil seconds between two runs
+    ---@field run fun(table:ecs.SystemTable) called for each matched table, an error disables the system
+
     ---@class ecs.world
+    ---@field query fun(self:ecs.world, components:table[]):ecs.Query
+    ---@field system fun(self:ecs.world, desc:ecs.SystemDesc):ecs.entity
     ---@overload entity fun(self:ecs.world):ecs.entity
     ---@overload entity fun(self:ecs.world, name:string):ecs.entity
     ---@overload prefab fun(self:ecs.world):ecs.entity
@@ -14,75 +14,97 @@ namespace lysa::ecs {
 #ifdef LUA_BINDING
         , const lysa::Lua& lua
 #endif
+        , const ECSConfiguration& config
         ):
         world(flecs::world()) {
         world.set<Context>({&ctx});
+        world.set<ECSConfiguration>(config);
+        world.set<Loader>({});
 #ifdef LUA_BINDING
-        LuaBindings::_register(lua);
+        LuaBindings::_register(lua, world);
         world.set<Lua>({&lua});
 #endif
         modules = std::make_unique<Modules>(world);
         ctx.events.subscribe(MainLoopEvent::PROCESS, [&] (const Event&){
-            if (!world.progress()) {
+            if (!progress()) {
                 ctx.exit = true;
             }
         });
     }
 
-    flecs::entity& load(flecs::entity& root, const std::string &fileURI) {
-        auto stream = root.world().get<Context>().ctx->fs.openReadStream(fileURI);
-        return load(root, stream);
+    ecs::~ecs() {
+#ifdef LUA_BINDING
+        LuaBindings::_unregister(world);
+#endif
     }
 
-    flecs::entity& load(flecs::entity& root, std::ifstream &stream) {
-        const auto& world = root.world();
-        const bool isPrefab = root.has(flecs::Prefab);
-        AssetsPack::load(*world.get<Context>().ctx, stream, [&](
-           const std::vector<AssetsPack::NodeHeader>& nodeHeaders,
-           const std::vector<unique_id>& meshes,
-           const std::vector<std::vector<uint32>>& childrenIndexes) {
-            std::vector<flecs::entity> entities{(nodeHeaders.size())};
-            for (auto nodeIndex = 0; nodeIndex < nodeHeaders.size(); ++nodeIndex) {
-                entities[nodeIndex] =
-                    world.entity(nodeHeaders[nodeIndex].name)
-                    .add<lysa::ecs::Visible>();
-                if (isPrefab) {
-                    entities[nodeIndex].add(flecs::Prefab);
-                }
-                if (nodeHeaders[nodeIndex].meshIndex != -1) {
-                    const auto meshId = meshes[nodeHeaders[nodeIndex].meshIndex];
-                    entities[nodeIndex].set<lysa::ecs::MeshInstance>({.mesh = meshId});
-                }
-                entities[nodeIndex].set<lysa::ecs::Transform>({.local = nodeHeaders[nodeIndex].transform});
-            }
-
-            // for (auto animationIndex = 0; animationIndex < header.animationsCount; animationIndex++) {
-            //   for (auto trackIndex = 0; trackIndex < animationHeaders[animationIndex].tracksCount; trackIndex++) {
-            //       auto nodeIndex = tracksInfos[animationIndex][trackIndex].nodeIndex;
-            //       auto& player = animationPlayers[nodeIndex];
-            //       if (!player->getParent()) {
-            //           auto& node = nodes[nodeIndex];
-            //           // player->setNode(node);
-            //           node->addChild(player);
-            //       }
-            //   }
-            // }
+    bool ecs::progress() {
+        if constexpr (PROFILER_ENABLED) {
+            Profiler::beginFrame();
+        }
+        const auto now = std::chrono::steady_clock::now();
+        const auto frameDeltaTime = lastFrameTime == std::chrono::steady_clock::time_point{} ?
+            0.0f :
+            std::chrono::duration<float>(now - lastFrameTime).count();
+        lastFrameTime = now;
 
-            // Build the scene tree
-            for (auto nodeIndex = 0; nodeIndex < nodeHeaders.size(); ++nodeIndex) {
-               auto& parent = entities[nodeIndex];
-               for (auto i = 0; i < nodeHeaders[nodeIndex].childrenCount; i++) {
-                   entities[childrenIndexes[nodeIndex][i]].add(flecs::ChildOf, parent);
-               }
+        const auto& config = world.get<ECSConfiguration>();
+#ifdef LUA_BINDING
+        {
+            const auto profile = ProfilerScope{"ecs.luaCommands"};
+            LuaBindings::mergeCommands(world);
+        }
+#endif
+        world.get_mut<Loader>().update(std::chrono::microseconds{config.loadTimeBudget}, config.loadNodesBudget);
+        auto time = world.get<SimulationTime>();
+        // The simulation systems read the time of the step they run in
+        if (config.fixedDeltaTime > 0.0f) {
+            simulationTimeAccumulator += frameDeltaTime;
+            auto steps = 0u;
+            time.deltaTime = config.fixedDeltaTime;
+            while (simulationTimeAccumulator >= config.fixedDeltaTime && steps < config.maxSimulationSteps) {
+                const auto profile = ProfilerScope{"ecs.simulation"};
+                time.ticks += 1;
+                world.set<SimulationTime>(time);
+                world.run_pipeline(modules->getSimulationPipeline(), config.fixedDeltaTime);
+                simulationTimeAccumulator -= config.fixedDeltaTime;
+                steps += 1;
             }
-            // find the top nodes, with no parents
-            for (auto &entity : entities) {
-                if (!entity.parent()) {
-                    entity.add(flecs::ChildOf, root);
-                }
+            // Drop the time we can't catch up with instead of spiraling on the next frames
+            if (simulationTimeAccumulator >= config.fixedDeltaTime) {
+                simulationTimeAccumulator = std::fmod(simulationTimeAccumulator, config.fixedDeltaTime);
             }
-        });
-        return root;
+            time.alpha = simulationTimeAccumulator / config.fixedDeltaTime;
+        } else {
+            const auto profile = ProfilerScope{"ecs.simulation"};
+            time.deltaTime = frameDeltaTime;
+            time.alpha = 1.0f;
+            time.ticks += 1;
+            world.set<SimulationTime>(time);
+            world.run_pipeline(modules->getSimulationPipeline(), frameDeltaTime);
+        }
+        // The presentation systems read the interpolation factor of the frame
+        world.set<SimulationTime>(time);
+        auto running = true;
+        {
+            const auto profile = ProfilerScope{"ecs.progress"};
+            running = world.progress(frameDeltaTime);
+        }
+        if (world.get<ECSConfiguration>().metrics) {
+            world.get_mut<MetricsModule>().sample(world);
+        }
+        return running;
+    }
+
+    const ECSMetrics& ecs::getMetrics() const {
+        assert([&]{ return world.get<ECSConfiguration>().metrics; }, "ECS metrics are disabled");
+        return world.get<MetricsModule>().getLast();
+    }
+
+    void ecs::dumpMetrics(const std::string& path) const {
+        assert([&]{ return world.get<ECSConfiguration>().metrics; }, "ECS metrics are disabled");
+        auto out = std::ofstream{path};
+        world.get<MetricsModule>().dump(out);
     }
 
 }
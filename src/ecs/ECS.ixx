@@ -9,6 +9,9 @@ export module lysa.ecs;
 import lysa;
 export import lysa.ecs.components;
 export import lysa.ecs.flecs;
+export import lysa.ecs.loader;
+export import lysa.ecs.profiler;
+export import lysa.ecs.snapshot;
 export import lysa.ecs.systems;
 #ifdef LUA_BINDING
 export import lysa.ecs.lua;
@@ -21,19 +24,38 @@ export namespace lysa::ecs {
 #ifdef LUA_BINDING
             , const lysa::Lua& lua
 #endif
+            , const ECSConfiguration& config = {}
         );
 
+        /**
+         * Releases the Lua references held by the world, the Lua state must still be alive
+         */
+        ~ecs();
+
+        /**
+         * Runs the simulation pipeline as many times as needed by the fixed time step
+         * then the default pipeline once. Returns false when the world asked to quit.
+         */
+        bool progress();
+
+        /**
+         * Returns the runtime metrics of the last frame.
+         * Requires ECSConfiguration::metrics
+         */
+        const ECSMetrics& getMetrics() const;
+
+        /**
+         * Writes the runtime metrics of the last ECSConfiguration::metricsHistory frames in a CSV file.
+         * Requires ECSConfiguration::metrics
+         */
+        void dumpMetrics(const std::string& path) const;
+
         flecs::world world;
         std::unique_ptr<Modules> modules;
-    };
 
-    flecs::entity& load(flecs::entity& root, const std::string &fileURI);
-    flecs::entity& load(flecs::entity& root, std::ifstream &stream);
-    flecs::entity& load(flecs::entity* root, const std::string &fileURI) {
-        return load(*root, fileURI);
-    }
-    flecs::entity& load(flecs::entity* root, std::ifstream &stream) {
-        return load(*root, stream);
-    }
+    private:
+        std::chrono::steady_clock::time_point lastFrameTime{};
+        float simulationTimeAccumulator{0.0f};
+    };
 
 }
@@ -12,3 +12,45 @@ module;
 
 export module lysa.ecs.flecs;
 #include "flecs.hpp"
+
+// Parts of the C API used beside the C++ API
+export {
+    using ::ecs_world_stats_t;
+    using ::ecs_world_stats_get;
+    using ::ecs_bulk_desc_t;
+    using ::ecs_bulk_init;
+    using ::ecs_iter_t;
+    using ::ecs_children;
+    using ::ecs_children_next;
+    using ::ecs_record_t;
+    using ::ecs_record_find;
+    using ::ecs_is_alive;
+    using ::ecs_is_valid;
+    using ::ecs_table_get_column;
+    using ::ecs_table_get_column_index;
+}
+
+export namespace lysa::ecs {
+
+    /**
+     * Defers the commands of a world for the lifetime of the scope,
+     * the commands are merged when the scope is left, also by an exception
+     */
+    class DeferScope {
+    public:
+        explicit DeferScope(const flecs::world& world): world(world) {
+            this->world.defer_begin();
+        }
+
+        ~DeferScope() {
+            world.defer_end();
+        }
+
+        DeferScope(const DeferScope&) = delete;
+        DeferScope& operator=(const DeferScope&) = delete;
+
+    private:
+        flecs::world world;
+    };
+
+}
@@ -0,0 +1,632 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module;
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+module lysa.ecs.loader;
+
+import lysa.ecs.components;
+import lysa.ecs.profiler;
+import lysa.ecs.systems;
+
+namespace lysa::ecs {
+
+    // Stream buffer reading from memory : the stream reads copy directly from the buffer
+    class MemoryBuffer : public std::streambuf {
+    public:
+        MemoryBuffer() = default;
+
+        explicit MemoryBuffer(const std::span<const char> bytes):
+            data(const_cast<char*>(bytes.data())),
+            size(bytes.size()) {
+            setg(data, data, data + size);
+        }
+
+    protected:
+        char* data{nullptr};
+        size_t size{0};
+
+        pos_type seekoff(const off_type off, const std::ios_base::seekdir dir, const std::ios_base::openmode which) override {
+            if (!(which & std::ios_base::in)) { return pos_type(off_type(-1)); }
+            auto position = off;
+            if (dir == std::ios_base::cur) {
+                position += gptr() - eback();
+            } else if (dir == std::ios_base::end) {
+                position += static_cast<off_type>(size);
+            }
+            return seekpos(pos_type(position), which);
+        }
+
+        pos_type seekpos(const pos_type pos, const std::ios_base::openmode which) override {
+            const auto position = static_cast<off_type>(pos);
+            if (!(which & std::ios_base::in) || position < 0 || position > static_cast<off_type>(size)) {
+                return pos_type(off_type(-1));
+            }
+            setg(data, data + position, data + size);
+            return pos;
+        }
+    };
+
+    // Read-only memory mapping of a file used as the get area of a stream buffer :
+    // the stream reads copy from the mapped pages into the pack reader structures
+    class MappedFile : public MemoryBuffer {
+    public:
+        explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+            file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error(std::format("Cannot open {}", path.string()));
+            }
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize)) {
+                CloseHandle(file);
+                throw std::runtime_error(std::format("Cannot get the size of {}", path.string()));
+            }
+            size = static_cast<size_t>(fileSize.QuadPart);
+            if (size > 0) {
+                mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (mapping == nullptr) {
+                    CloseHandle(file);
+                    throw std::runtime_error(std::format("Cannot map {}", path.string()));
+                }
+                data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                if (data == nullptr) {
+                    CloseHandle(mapping);
+                    CloseHandle(file);
+                    throw std::runtime_error(std::format("Cannot map {}", path.string()));
+                }
+            }
+#else
+            const auto fd = open(path.c_str(), O_RDONLY);
+            if (fd == -1) {
+                throw std::runtime_error(std::format("Cannot open {}", path.string()));
+            }
+            struct stat st{};
+            if (fstat(fd, &st) == -1) {
+                close(fd);
+                throw std::runtime_error(std::format("Cannot get the size of {}", path.string()));
+            }
+            size = static_cast<size_t>(st.st_size);
+            if (size > 0) {
+                auto* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped == MAP_FAILED) {
+                    close(fd);
+                    throw std::runtime_error(std::format("Cannot map {}", path.string()));
+                }
+                madvise(mapped, size, MADV_SEQUENTIAL);
+                data = static_cast<char*>(mapped);
+            }
+            close(fd);
+#endif
+            setg(data, data, data + size);
+        }
+
+        ~MappedFile() override {
+#ifdef _WIN32
+            if (data) { UnmapViewOfFile(data); }
+            if (mapping) { CloseHandle(mapping); }
+            CloseHandle(file);
+#else
+            if (data) { munmap(data, size); }
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+    private:
+#ifdef _WIN32
+        HANDLE file{INVALID_HANDLE_VALUE};
+        HANDLE mapping{nullptr};
+#endif
+    };
+
+    // AssetsPack reads from a std::ifstream, the memory buffer replaces the stream buffer of an unopened stream.
+    // It only works while AssetsPack reads through the std::istream interface : ifstream::rdbuf()
+    // still returns the unopened file buffer and is_open() returns false
+    static AssetsPackNodes readBuffer(lysa::Context& ctx, std::streambuf& buffer) {
+        auto stream = std::ifstream{};
+        stream.std::ios::rdbuf(&buffer);
+        stream.clear();
+        return AssetsPackNodes::read(ctx, stream);
+    }
+
+    AssetsPackNodes AssetsPackNodes::read(lysa::Context& ctx, const std::filesystem::path& path) {
+        auto mappedFile = MappedFile{path};
+        return readBuffer(ctx, mappedFile);
+    }
+
+    AssetsPackNodes AssetsPackNodes::read(lysa::Context& ctx, const std::span<const char> bytes) {
+        auto buffer = MemoryBuffer{bytes};
+        return readBuffer(ctx, buffer);
+    }
+
+    std::vector<char> AssetsPackNodes::readFile(lysa::Context& ctx, const std::string& fileURI) {
+        auto stream = ctx.fs.openReadStream(fileURI);
+        auto bytes = std::vector<char>{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+        if (stream.bad()) {
+            throw std::runtime_error(std::format("Cannot read {}", fileURI));
+        }
+        return bytes;
+    }
+
+    AssetsPackNodes AssetsPackNodes::read(lysa::Context& ctx, std::ifstream& stream) {
+        const auto profile = ProfilerScope{"ecs.load.read"};
+        auto pack = AssetsPackNodes{};
+        AssetsPack::load(ctx, stream, [&](
+           const std::vector<AssetsPack::NodeHeader>& nodeHeaders,
+           const std::vector<unique_id>& meshes,
+           const std::vector<std::vector<uint32>>& childrenIndexes) {
+            pack.nodes.reserve(nodeHeaders.size());
+            // index in nodeHeaders of each node of the pack
+            auto sources = std::vector<uint32>{};
+            sources.reserve(nodeHeaders.size());
+
+            // Appends the children of a node, grouped by components
+            const auto appendChildren = [&](const std::vector<uint32>& children, const int32 parent) {
+                for (const auto withMesh : {true, false}) {
+                    const auto first = static_cast<uint32>(pack.nodes.size());
+                    for (const auto nodeIndex : children) {
+                        const auto& header = nodeHeaders[nodeIndex];
+                        if ((header.meshIndex != -1) != withMesh) { continue; }
+                        pack.nodes.push_back({
+                            .name = std::string{header.name},
+                            .transform = header.transform,
+                            .mesh = withMesh ? meshes[header.meshIndex] : INVALID_ID,
+                            .parent = parent,
+                        });
+                        sources.push_back(nodeIndex);
+                    }
+                    const auto count = static_cast<uint32>(pack.nodes.size()) - first;
+                    if (count > 0) {
+                        pack.groups.push_back({first, count});
+                    }
+                }
+            };
+
+            // find the top nodes, with no parents
+            auto hasParent = std::vector<bool>(nodeHeaders.size(), false);
+            for (auto nodeIndex = 0; nodeIndex < nodeHeaders.size(); ++nodeIndex) {
+                for (auto i = 0; i < nodeHeaders[nodeIndex].childrenCount; i++) {
+                    hasParent[childrenIndexes[nodeIndex][i]] = true;
+                }
+            }
+            auto topNodes = std::vector<uint32>{};
+            for (auto nodeIndex = 0; nodeIndex < nodeHeaders.size(); ++nodeIndex) {
+                if (!hasParent[nodeIndex]) {
+                    topNodes.push_back(nodeIndex);
+                }
+            }
+            appendChildren(topNodes, -1);
+
+            // Build the scene tree breadth first, the nodes appended are visited after their parents
+            for (auto i = 0; i < pack.nodes.size(); ++i) {
+                const auto source = sources[i];
+                const auto& children = childrenIndexes[source];
+                const auto first = children.begin();
+                appendChildren({first, first + nodeHeaders[source].childrenCount}, i);
+            }
+
+            // for (auto animationIndex = 0; animationIndex < header.animationsCount; animationIndex++) {
+            //   for (auto trackIndex = 0; trackIndex < animationHeaders[animationIndex].tracksCount; trackIndex++) {
+            //       auto nodeIndex = tracksInfos[animationIndex][trackIndex].nodeIndex;
+            //       auto& player = animationPlayers[nodeIndex];
+            //       if (!player->getParent()) {
+            //           auto& node = nodes[nodeIndex];
+            //           // player->setNode(node);
+            //           node->addChild(player);
+            //       }
+            //   }
+            // }
+        });
+        return pack;
+    }
+
+    AssetsPackInstantiation::AssetsPackInstantiation(
+        const flecs::entity& root,
+        std::shared_ptr<const AssetsPackNodes> nodes):
+        root(root),
+        nodes(std::move(nodes)),
+        rootGlobal(root.has<Transform>() ? root.get<Transform>().global : float4x4::identity()),
+        names(root.world().get<ECSConfiguration>().loadNodeNames),
+        entities(this->nodes->nodes.size()),
+        globals(this->nodes->nodes.size()) {
+        if (names == NodeNames::Interned) {
+            auto& retained = root.ensure<RetainedNodes>().nodes;
+            if (std::ranges::find(retained, this->nodes) == retained.end()) {
+                retained.push_back(this->nodes);
+            }
+        }
+    }
+
+    float AssetsPackInstantiation::getProgress() const {
+        return nodes->nodes.empty() ? 1.0f : static_cast<float>(createdNodes) / nodes->nodes.size();
+    }
+
+    bool AssetsPackInstantiation::update(const std::chrono::microseconds budget, const uint32 nodeBudget) {
+        const auto profile = ProfilerScope{"ecs.load.instantiate"};
+        const auto start = std::chrono::steady_clock::now();
+        const auto world = root.world();
+        // The nodes are created deferred, with the per-component instance registration of the observers
+        // suspended: the commands are merged once at the end then each instance is created once
+        auto& meshInstanceModule = world.get_mut<MeshInstanceModule>();
+        {
+            const auto suspension = MeshInstanceModule::Suspension{meshInstanceModule};
+            const auto defer = DeferScope{world};
+            auto created = 0u;
+            while (!isComplete()) {
+                // A group is split when it does not fit in the remaining nodes budget,
+                // and in slices with a time budget so one large group can't overrun it
+                const auto& group = nodes->groups[nextGroup];
+                auto count = group.count - nextGroupOffset;
+                if (nodeBudget > 0) {
+                    count = std::min(count, nodeBudget - created);
+                }
+                if (budget.count() > 0) {
+                    count = std::min(count, TIME_CHECK_NODES);
+                }
+                createGroup(world, {group.first + nextGroupOffset, count});
+                created += count;
+                nextGroupOffset += count;
+                if (nextGroupOffset == group.count) {
+                    nextGroup += 1;
+                    nextGroupOffset = 0;
+                }
+                if ((nodeBudget > 0 && created >= nodeBudget) ||
+                    (budget.count() > 0 && std::chrono::steady_clock::now() - start >= budget)) {
+                    break;
+                }
+            }
+        }
+        if (isComplete()) {
+            for (auto i = 0; i < nodes->nodes.size() && nodes->nodes[i].parent == -1; ++i) {
+                meshInstanceModule.addInstances(flecs::entity(world, entities[i]));
+            }
+        }
+        return isComplete();
+    }
+
+    // Creates nodes with the same parent and components in one bulk operation
+    // directly in their final table, the components are moved in place
+    void AssetsPackInstantiation::createGroup(const flecs::world& world, const AssetsPackNodes::Group& group) {
+        const auto& first = nodes->nodes[group.first];
+        const auto parent = first.parent == -1 ? root.id() : entities[first.parent];
+        const auto& parentGlobal = first.parent == -1 ? rootGlobal : globals[first.parent];
+        const auto withMesh = first.mesh != INVALID_ID;
+        const bool isPrefab = root.has(flecs::Prefab);
+
+        auto transforms = std::vector<Transform>{};
+        auto meshInstances = std::vector<MeshInstance>{};
+        auto nodeNames = std::vector<NodeName>{};
+        transforms.reserve(group.count);
+        for (auto nodeIndex = group.first; nodeIndex < group.first + group.count; ++nodeIndex) {
+            const auto& node = nodes->nodes[nodeIndex];
+            globals[nodeIndex] = mul(node.transform, parentGlobal);
+            transforms.push_back({.local = node.transform, .global = globals[nodeIndex]});
+            if (withMesh) {
+                meshInstances.push_back({.mesh = node.mesh});
+            }
+            if (names == NodeNames::Interned) {
+                nodeNames.push_back({node.name.c_str()});
+            }
+        }
+
+        auto desc = ecs_bulk_desc_t{};
+        auto data = std::array<void*, 8>{};
+        auto idCount = 0;
+        desc.ids[idCount++] = world.id<Visible>();
+        data[idCount] = transforms.data();
+        desc.ids[idCount++] = world.id<Transform>();
+        if (withMesh) {
+            data[idCount] = meshInstances.data();
+            desc.ids[idCount++] = world.id<MeshInstance>();
+        }
+        desc.ids[idCount++] = world.pair(flecs::ChildOf, parent);
+        if (names == NodeNames::Named) {
+            desc.ids[idCount++] = world.pair<flecs::Identifier>(flecs::Name);
+        } else if (names == NodeNames::Interned) {
+            data[idCount] = nodeNames.data();
+            desc.ids[idCount++] = world.id<NodeName>();
+        }
+        if (isPrefab) {
+            desc.ids[idCount++] = flecs::Prefab;
+        }
+        desc.count = static_cast<int32>(group.count);
+        desc.data = data.data();
+        const auto* created = ecs_bulk_init(world.c_ptr(), &desc);
+        std::copy_n(created, group.count, entities.begin() + group.first);
+        if (names == NodeNames::Named) {
+            // The entities already have the name component, naming them does not move them.
+            // The empty names are skipped and the duplicated sibling names are suffixed
+            auto& used = siblingNames[parent];
+            const auto parentEntity = flecs::entity(world, parent);
+            for (auto nodeIndex = group.first; nodeIndex < group.first + group.count; ++nodeIndex) {
+                const auto& name = nodes->nodes[nodeIndex].name;
+                if (name.empty()) { continue; }
+                flecs::entity(world, entities[nodeIndex]).set_name(uniqueChildName(parentEntity, name, used).c_str());
+            }
+        }
+        createdNodes += group.count;
+    }
+
+    // The root can come from a system, its handle is bound to the world instead of the stage of the system :
+    // the nodes are created after the pipeline, when the stage is no longer in use
+    AsyncLoad::AsyncLoad(const flecs::entity& root, std::future<std::vector<char>> reading):
+        root(root.world().get_world().c_ptr(), root.id()),
+        reading(std::move(reading)) {
+    }
+
+    float AsyncLoad::getProgress() const {
+        if (loaded || failed) { return 1.0f; }
+        return instantiation ? instantiation->getProgress() : 0.0f;
+    }
+
+    bool AsyncLoad::isReading() const {
+        return reading.valid() && reading.wait_for(std::chrono::seconds{0}) != std::future_status::ready;
+    }
+
+    bool AsyncLoad::update(const std::chrono::microseconds budget, const uint32 nodeBudget) {
+        lastCreatedNodes = 0;
+        if (loaded || failed) { return true; }
+        if (!root.is_alive()) {
+            // The root was destroyed before the end of the load
+            loaded = true;
+            return true;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        if (!instantiation) {
+            if (reading.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                return false;
+            }
+            // The pack is decoded on the main thread, it creates the meshes, materials and textures.
+            // The errors of the worker thread are rethrown by get()
+            try {
+                const auto bytes = reading.get();
+                instantiation = std::make_unique<AssetsPackInstantiation>(
+                    root,
+                    std::make_shared<const AssetsPackNodes>(
+                        AssetsPackNodes::read(*root.world().get<Context>().ctx, std::span{bytes})));
+            } catch (const std::exception& e) {
+                error = e.what();
+                failed = true;
+                return true;
+            }
+        }
+        auto remaining = budget;
+        if (budget.count() > 0) {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            if (elapsed >= budget) { return false; }
+            remaining = budget - elapsed;
+        }
+        const auto createdNodes = instantiation->getCreatedNodes();
+        loaded = instantiation->update(remaining, nodeBudget);
+        lastCreatedNodes = static_cast<uint32>(instantiation->getCreatedNodes() - createdNodes);
+        if (loaded) {
+            instantiation.reset();
+        }
+        return loaded;
+    }
+
+    std::shared_ptr<AsyncLoad> Loader::loadAsync(const flecs::entity& root, const std::string& fileURI) {
+        auto* ctx = root.world().get<Context>().ctx;
+        // Only the file is read on the worker thread
+        auto load = std::make_shared<AsyncLoad>(root, std::async(std::launch::async, [ctx, fileURI] {
+            return AssetsPackNodes::readFile(*ctx, fileURI);
+        }));
+        loads.push_back(load);
+        return load;
+    }
+
+    float Loader::getProgress() const {
+        if (loads.empty()) { return 1.0f; }
+        auto progress = 0.0f;
+        for (const auto& load : loads) {
+            progress += load->getProgress();
+        }
+        return progress / loads.size();
+    }
+
+    void Loader::update(const std::chrono::microseconds budget, const uint32 nodeBudget) {
+        const auto start = std::chrono::steady_clock::now();
+        auto remainingNodes = nodeBudget;
+        for (auto it = loads.begin(); it != loads.end();) {
+            if ((*it)->isCanceled()) {
+                // Destroying the future of std::async waits for the worker thread,
+                // the canceled loads are dropped once the pack is read
+                it = (*it)->isReading() ? std::next(it) : loads.erase(it);
+                continue;
+            }
+            if ((*it)->isReading()) {
+                // The loads already read don't wait for the previous ones
+                ++it;
+                continue;
+            }
+            auto remaining = std::chrono::microseconds{0};
+            if (budget.count() > 0) {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start);
+                if (elapsed >= budget) { return; }
+                remaining = budget - elapsed;
+            }
+            const auto load = *it;
+            const auto complete = load->update(remaining, remainingNodes);
+            if (complete) {
+                it = loads.erase(it);
+            }
+            if (nodeBudget > 0) {
+                remainingNodes -= std::min(remainingNodes, load->getLastCreatedNodes());
+                if (remainingNodes == 0) { return; }
+            }
+            if (!complete) {
+                // The budget is exhausted, the next loads are continued after this one
+                return;
+            }
+        }
+    }
+
+    flecs::entity Loader::getPrefab(const flecs::world& world, const std::string& fileURI) {
+        if (const auto it = prefabs.find(fileURI); it != prefabs.end() && it->second.is_alive()) {
+            return it->second;
+        }
+        auto prefab = world.prefab();
+        load(prefab, fileURI);
+        prefabs[fileURI] = prefab;
+        return prefab;
+    }
+
+    void Loader::clearPrefabs() {
+        for (const auto& prefab : prefabs | std::views::values) {
+            if (prefab.is_alive()) {
+                prefab.destruct();
+            }
+        }
+        prefabs.clear();
+    }
+
+    std::string_view getNodeName(const flecs::entity& e) {
+        if (e.has<NodeName>()) {
+            return e.get<NodeName>().name;
+        }
+        const auto name = e.name();
+        return name.c_str() ? name.c_str() : "";
+    }
+
+    flecs::entity findNode(const flecs::entity& root, const std::string_view name) {
+        auto found = flecs::entity{};
+        root.children([&](const flecs::entity& child) {
+            if (found) { return; }
+            if (getNodeName(child) == name) {
+                found = child;
+            } else {
+                found = findNode(child, name);
+            }
+        });
+        return found;
+    }
+
+    std::string uniqueChildName(const flecs::entity& parent, const std::string& name, std::unordered_set<std::string>& used) {
+        auto unique = name;
+        for (auto suffix = 1; used.contains(unique) || parent.lookup(unique.c_str()); ++suffix) {
+            unique = std::format("{}_{}", name, suffix);
+        }
+        used.insert(unique);
+        return unique;
+    }
+
+    // Computes the world transforms of a new subtree without tagging the nodes with Updated :
+    // the mesh instances are created afterward with these transforms
+    static void setGlobalTransforms(const flecs::entity& e, const float4x4& parentGlobal) {
+        auto& t = e.get_mut<Transform>();
+        t.global = mul(t.local, parentGlobal);
+        e.children([&](const flecs::entity& child) {
+            if (child.has<Transform>()) {
+                setGlobalTransforms(child, t.global);
+            }
+        });
+    }
+
+    flecs::entity& instantiate(flecs::entity& root, const std::string &fileURI) {
+        const auto profile = ProfilerScope{"ecs.instantiate"};
+        const auto world = root.world();
+        const auto prefab = world.get_mut<Loader>().getPrefab(world, fileURI);
+        auto existing = std::unordered_set<flecs::entity_t>{};
+        root.children([&](const flecs::entity& child) {
+            existing.insert(child.id());
+        });
+        // The prefab children are copied table by table, the mesh instances are registered once afterward
+        auto& meshInstanceModule = world.get_mut<MeshInstanceModule>();
+        {
+            const auto suspension = MeshInstanceModule::Suspension{meshInstanceModule};
+            root.is_a(prefab);
+        }
+        auto instances = std::vector<flecs::entity>{};
+        root.children([&](const flecs::entity& child) {
+            if (!existing.contains(child.id()) && child.has<Transform>()) {
+                instances.push_back(child);
+            }
+        });
+        // The world transforms copied from the prefab are relative to the prefab root
+        const auto rootGlobal = root.has<Transform>() ? root.get<Transform>().global : float4x4::identity();
+        for (const auto& child : instances) {
+            setGlobalTransforms(child, rootGlobal);
+            meshInstanceModule.addInstances(child);
+        }
+        return root;
+    }
+
+    flecs::entity& load(flecs::entity& root, const std::string &fileURI) {
+        auto stream = root.world().get<Context>().ctx->fs.openReadStream(fileURI);
+        return load(root, stream);
+    }
+
+    flecs::entity& load(flecs::entity& root, std::ifstream &stream) {
+        const auto profile = ProfilerScope{"ecs.load"};
+        auto instantiation = AssetsPackInstantiation{
+            root,
+            std::make_shared<const AssetsPackNodes>(AssetsPackNodes::read(*root.world().get<Context>().ctx, stream))};
+        instantiation.update();
+        return root;
+    }
+
+    void loadBatch(const std::vector<std::pair<flecs::entity, std::string>>& packs) {
+        if (packs.empty()) { return; }
+        const auto profile = ProfilerScope{"ecs.load.batch"};
+        auto* ctx = packs.front().first.world().get<Context>().ctx;
+        auto results = std::vector<std::promise<std::vector<char>>>(packs.size());
+        auto reads = std::vector<std::future<std::vector<char>>>{};
+        reads.reserve(packs.size());
+        for (auto& result : results) {
+            reads.push_back(result.get_future());
+        }
+        auto nextPack = std::atomic<size_t>{0};
+        const auto workerCount = std::min<size_t>(packs.size(), std::max(1u, std::thread::hardware_concurrency()));
+        // The workers are joined before leaving, even when a merge throws
+        auto workers = std::vector<std::jthread>{};
+        workers.reserve(workerCount);
+        for (auto i = 0; i < workerCount; ++i) {
+            workers.emplace_back([&] {
+                for (auto index = nextPack.fetch_add(1); index < packs.size(); index = nextPack.fetch_add(1)) {
+                    try {
+                        results[index].set_value(AssetsPackNodes::readFile(*ctx, packs[index].second));
+                    } catch (...) {
+                        results[index].set_exception(std::current_exception());
+                    }
+                }
+            });
+        }
+        // Flecs entities and the resources of the packs can only be created on the main thread,
+        // the packs are decoded and merged while the next files are read
+        for (auto index = 0; index < packs.size(); ++index) {
+            const auto bytes = reads[index].get();
+            auto instantiation = AssetsPackInstantiation{
+                packs[index].first,
+                std::make_shared<const AssetsPackNodes>(AssetsPackNodes::read(*ctx, std::span{bytes}))};
+            instantiation.update();
+        }
+    }
+
+    flecs::entity& loadMapped(flecs::entity& root, const std::filesystem::path& path) {
+        const auto profile = ProfilerScope{"ecs.load"};
+        auto instantiation = AssetsPackInstantiation{
+            root,
+            std::make_shared<const AssetsPackNodes>(AssetsPackNodes::read(*root.world().get<Context>().ctx, path))};
+        instantiation.update();
+        return root;
+    }
+
+    std::shared_ptr<AsyncLoad> loadAsync(const flecs::entity& root, const std::string &fileURI) {
+        return root.world().get_mut<Loader>().loadAsync(root, fileURI);
+    }
+
+}
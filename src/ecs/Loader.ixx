@@ -0,0 +1,309 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module lysa.ecs.loader;
+
+import std;
+import lysa;
+export import lysa.ecs.flecs;
+
+export namespace lysa::ecs {
+
+    /**
+     * Nodes of an assets pack read from a stream and ready to be instantiated.
+     *
+     * The nodes are stored breadth first, the parents before their children, and the children of a node
+     * are grouped by components so each group can be created in one bulk operation
+     */
+    struct AssetsPackNodes {
+        struct Node {
+            std::string name;
+            //! Local transform
+            float4x4 transform{float4x4::identity()};
+            //! Mesh of the instance, INVALID_ID for the nodes without mesh
+            unique_id mesh{INVALID_ID};
+            //! Index of the parent node, -1 for the top nodes
+            int32 parent{-1};
+        };
+
+        //! Contiguous nodes with the same parent and the same components
+        struct Group {
+            uint32 first;
+            uint32 count;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<Group> groups;
+
+        /**
+         * Reads the nodes of an assets pack.
+         * Must be called from the main thread, the meshes, materials and textures of the pack
+         * are created in the resources managers
+         */
+        static AssetsPackNodes read(lysa::Context& ctx, std::ifstream& stream);
+
+        /**
+         * Reads the nodes of an assets pack already in memory
+         */
+        static AssetsPackNodes read(lysa::Context& ctx, std::span<const char> bytes);
+
+        /**
+         * Reads the content of an assets pack file without decoding it, can be called from any thread
+         */
+        static std::vector<char> readFile(lysa::Context& ctx, const std::string& fileURI);
+
+        /**
+         * Reads the nodes of an assets pack file through a read-only memory mapping of the file.
+         * The file is read without the file stream buffer and read calls, the headers, names
+         * and children indexes are still copied by the pack reader
+         */
+        static AssetsPackNodes read(lysa::Context& ctx, const std::filesystem::path& path);
+    };
+
+    /**
+     * Instantiation of the nodes of an assets pack under a root entity, possibly over several frames
+     */
+    class AssetsPackInstantiation {
+    public:
+        AssetsPackInstantiation(const flecs::entity& root, std::shared_ptr<const AssetsPackNodes> nodes);
+
+        /**
+         * Creates the next nodes until all the nodes are created or one of the budgets is exceeded.
+         * The mesh instances are registered once all the nodes are created :
+         * the subtree is not rendered until it is complete.
+         * @param budget Time budget, 0 for unlimited
+         * @param nodeBudget Maximum number of nodes to create, 0 for unlimited
+         * @return true when all the nodes are created
+         */
+        bool update(std::chrono::microseconds budget = std::chrono::microseconds{0}, uint32 nodeBudget = 0);
+
+        /**
+         * Returns true when all the nodes are created
+         */
+        bool isComplete() const { return nextGroup == nodes->groups.size(); }
+
+        /**
+         * Returns the fraction of the nodes created
+         */
+        float getProgress() const;
+
+        /**
+         * Returns the number of nodes created
+         */
+        size_t getCreatedNodes() const { return createdNodes; }
+
+    private:
+        //! Maximum number of nodes created between two checks of the time budget
+        static constexpr uint32 TIME_CHECK_NODES{64};
+
+        flecs::entity root;
+        std::shared_ptr<const AssetsPackNodes> nodes;
+        float4x4 rootGlobal;
+        NodeNames names;
+        size_t nextGroup{0};
+        //! Nodes of the next group already created
+        uint32 nextGroupOffset{0};
+        size_t createdNodes{0};
+        std::vector<flecs::entity_t> entities;
+        std::vector<float4x4> globals;
+        //! Names given to the children of each parent with NodeNames::Named, to make the sibling names unique
+        std::unordered_map<flecs::entity_t, std::unordered_set<std::string>> siblingNames;
+
+        void createGroup(const flecs::world& world, const AssetsPackNodes::Group& group);
+    };
+
+    /**
+     * Assets packs loaded under an entity with NodeNames::Interned, kept alive for the NodeName components
+     * pointing into them and released with the entity or when a streaming cell is unloaded.
+     * The nodes moved out of the subtree of the entity must not outlive it
+     */
+    struct RetainedNodes {
+        std::vector<std::shared_ptr<const AssetsPackNodes>> nodes;
+    };
+
+    /**
+     * Handle of an asynchronous load.
+     *
+     * Only the assets pack file is read on a worker thread. The pack is then decoded on the main thread
+     * in one step, creating its meshes, materials and textures, and its nodes are created in the world
+     * at the frame boundary. The decoding time is counted in ECSConfiguration::loadTimeBudget
+     * but a pack is never decoded over several frames : a large pack can exceed the budget of its frame
+     */
+    class AsyncLoad : public std::enable_shared_from_this<AsyncLoad> {
+    public:
+        AsyncLoad(const flecs::entity& root, std::future<std::vector<char>> reading);
+
+        /**
+         * Returns true when the nodes are created in the world
+         */
+        bool isLoaded() const { return loaded; }
+
+        /**
+         * Returns true if the pack could not be read, no nodes were created
+         */
+        bool isFailed() const { return failed; }
+
+        /**
+         * Returns the reading error of a failed load
+         */
+        const std::string& getError() const { return error; }
+
+        /**
+         * Returns the fraction of the nodes created in the world
+         */
+        float getProgress() const;
+
+        /**
+         * Returns the root entity of the loaded nodes
+         */
+        const flecs::entity& getRoot() const { return root; }
+
+        /**
+         * Decodes the pack once it is read then creates the nodes in the world within the budgets.
+         * The nodes creation starts the next frame when the decoding used the time budget.
+         * Must be called from the main thread, outside of the pipeline.
+         * @return true when the load is complete or failed
+         */
+        bool update(std::chrono::microseconds budget, uint32 nodeBudget = 0);
+
+        /**
+         * Returns the number of nodes created in the world by the last update()
+         */
+        uint32 getLastCreatedNodes() const { return lastCreatedNodes; }
+
+        /**
+         * Stops the creation of the nodes, the nodes already created are kept
+         */
+        void cancel() { canceled = true; }
+
+        /**
+         * Returns true if the load was canceled
+         */
+        bool isCanceled() const { return canceled; }
+
+        /**
+         * Returns true while the pack is read by the worker thread
+         */
+        bool isReading() const;
+
+    private:
+        flecs::entity root;
+        std::future<std::vector<char>> reading;
+        std::unique_ptr<AssetsPackInstantiation> instantiation;
+        std::string error;
+        uint32 lastCreatedNodes{0};
+        bool loaded{false};
+        bool failed{false};
+        bool canceled{false};
+    };
+
+    /**
+     * Pending asynchronous loads, stored as a world singleton
+     */
+    class Loader {
+    public:
+        /**
+         * Starts reading an assets pack on a worker thread
+         */
+        std::shared_ptr<AsyncLoad> loadAsync(const flecs::entity& root, const std::string& fileURI);
+
+        /**
+         * Merges the pending loads into the world, oldest first, within the budgets.
+         * Called by ecs::progress() at the frame boundary with ECSConfiguration::loadTimeBudget
+         * and ECSConfiguration::loadNodesBudget
+         */
+        void update(std::chrono::microseconds budget, uint32 nodeBudget = 0);
+
+        /**
+         * Returns the number of loads not yet complete
+         */
+        size_t getPendingLoads() const { return loads.size(); }
+
+        /**
+         * Returns the mean progress of the pending loads, 1 when there are none
+         */
+        float getProgress() const;
+
+        /**
+         * Returns the prefab holding the nodes of an assets pack,
+         * the pack is read and the prefab hierarchy is built on the first call for an URI
+         */
+        flecs::entity getPrefab(const flecs::world& world, const std::string& fileURI);
+
+        /**
+         * Destroys the cached prefabs, the entities already instantiated from them are kept
+         */
+        void clearPrefabs();
+
+    private:
+        std::list<std::shared_ptr<AsyncLoad>> loads;
+        std::unordered_map<std::string, flecs::entity> prefabs;
+    };
+
+    /**
+     * Returns the name of a loaded node, whatever the ECSConfiguration::loadNodeNames used to load it
+     */
+    std::string_view getNodeName(const flecs::entity& e);
+
+    /**
+     * Finds a node by name in the subtree of the root entity, depth first.
+     * Resolves the interned names the world names index does not know
+     */
+    flecs::entity findNode(const flecs::entity& root, std::string_view name);
+
+    /**
+     * Returns a name for a new child of the parent : the name suffixed with _1, _2... when it is already used
+     * by a child of the parent or in the used names, to which it is added.
+     * flecs rejects two children with the same name
+     */
+    std::string uniqueChildName(const flecs::entity& parent, const std::string& name, std::unordered_set<std::string>& used);
+
+    flecs::entity& load(flecs::entity& root, const std::string &fileURI);
+    flecs::entity& load(flecs::entity& root, std::ifstream &stream);
+    flecs::entity& load(flecs::entity* root, const std::string &fileURI) {
+        return load(*root, fileURI);
+    }
+    flecs::entity& load(flecs::entity* root, std::ifstream &stream) {
+        return load(*root, stream);
+    }
+
+    /**
+     * Loads several assets packs, each one under its root entity.
+     * The files are read in parallel by a pool of worker threads, the packs are decoded and merged in the world
+     * on the calling thread in the order of the list, each pack as soon as its file is read,
+     * so the created entities do not depend on the threads scheduling
+     */
+    void loadBatch(const std::vector<std::pair<flecs::entity, std::string>>& packs);
+
+    /**
+     * Instantiates the nodes of an assets pack under the root entity from a prefab cached by URI.
+     * The pack is read once, the next calls copy the prefab hierarchy table by table
+     * with IsA and only compute the per-instance world transforms and create the mesh instances.
+     * flecs copies the components of the prefab children into each instance : the load time drops,
+     * the memory used by each instance does not.
+     * The root must not already be an instance of the same pack
+     */
+    flecs::entity& instantiate(flecs::entity& root, const std::string &fileURI);
+    flecs::entity& instantiate(flecs::entity* root, const std::string &fileURI) {
+        return instantiate(*root, fileURI);
+    }
+
+    /**
+     * Loads an assets pack file under the root entity, reading the file through a memory mapping.
+     * Use load() with an URI or a stream for the files not directly on disk
+     */
+    flecs::entity& loadMapped(flecs::entity& root, const std::filesystem::path& path);
+
+    /**
+     * Loads an assets pack under the root entity without blocking,
+     * the returned handle reports when the nodes are in the world
+     */
+    std::shared_ptr<AsyncLoad> loadAsync(const flecs::entity& root, const std::string &fileURI);
+    std::shared_ptr<AsyncLoad> loadAsync(const flecs::entity* root, const std::string &fileURI) {
+        return loadAsync(*root, fileURI);
+    }
+
+}
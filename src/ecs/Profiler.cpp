@@ -0,0 +1,147 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module lysa.ecs.profiler;
+
+namespace lysa::ecs {
+
+    // A slot is written by one thread at a time, the sequence number is odd while the
+    // slot is being written and tells the readers which ring buffer turn the slot belongs to.
+    // The fields are atomics so a reader racing with a writer reads torn values, not undefined behavior,
+    // and then discards them with the sequence check
+    struct ProfilerSlot {
+        std::atomic<uint64> sequence{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64> frame{0};
+        std::atomic<uint64> start{0};
+        std::atomic<uint64> duration{0};
+        std::atomic<uint32> thread{0};
+    };
+
+    static std::array<ProfilerSlot, Profiler::CAPACITY> profilerSlots;
+    static std::atomic<uint64> profilerWriteIndex{0};
+    static std::atomic<uint64> profilerFrame{0};
+    static std::atomic<uint32> profilerThreadCount{0};
+    static const auto profilerStart = std::chrono::steady_clock::now();
+
+    void Profiler::beginFrame() {
+        profilerFrame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64 Profiler::getFrame() {
+        return profilerFrame.load(std::memory_order_relaxed);
+    }
+
+    uint64 Profiler::now() {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - profilerStart).count());
+    }
+
+    void Profiler::record(const char* name, const uint64 start, const uint64 duration) {
+        thread_local const auto thread = profilerThreadCount.fetch_add(1, std::memory_order_relaxed);
+        const auto index = profilerWriteIndex.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = profilerSlots[index % CAPACITY];
+        slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.frame.store(profilerFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.duration.store(duration, std::memory_order_relaxed);
+        slot.thread.store(thread, std::memory_order_relaxed);
+        slot.sequence.store(index * 2 + 2, std::memory_order_release);
+    }
+
+    std::vector<ProfilerEvent> Profiler::getEvents() {
+        const auto end = profilerWriteIndex.load(std::memory_order_acquire);
+        const auto begin = end > CAPACITY ? end - CAPACITY : 0;
+        auto events = std::vector<ProfilerEvent>{};
+        events.reserve(end - begin);
+        for (auto index = begin; index < end; ++index) {
+            const auto& slot = profilerSlots[index % CAPACITY];
+            if (slot.sequence.load(std::memory_order_acquire) != index * 2 + 2) { continue; }
+            const auto event = ProfilerEvent{
+                .name = slot.name.load(std::memory_order_relaxed),
+                .frame = slot.frame.load(std::memory_order_relaxed),
+                .start = slot.start.load(std::memory_order_relaxed),
+                .duration = slot.duration.load(std::memory_order_relaxed),
+                .thread = slot.thread.load(std::memory_order_relaxed),
+            };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Skip the slot if a writer reused it while we were copying
+            if (slot.sequence.load(std::memory_order_relaxed) != index * 2 + 2) { continue; }
+            events.push_back(event);
+        }
+        return events;
+    }
+
+    std::vector<ProfilerStat> Profiler::getFrameStats(uint64 frame) {
+        if (frame == 0) {
+            frame = getFrame();
+            if (frame == 0) { return {}; }
+            frame -= 1;
+        }
+        auto stats = std::vector<ProfilerStat>{};
+        for (const auto& event : getEvents()) {
+            if (event.frame != frame) { continue; }
+            auto stat = std::ranges::find_if(stats, [&](const ProfilerStat& s) {
+                return s.name == event.name;
+            });
+            if (stat == stats.end()) {
+                stats.push_back({ .name = event.name });
+                stat = stats.end() - 1;
+            }
+            stat->count += 1;
+            stat->duration += event.duration;
+        }
+        return stats;
+    }
+
+    // Escapes a scope name for a JSON string, the Lua scope names contain file paths
+    static std::string escapeJson(const std::string_view name) {
+        auto escaped = std::string{};
+        escaped.reserve(name.size());
+        for (const auto c : name) {
+            switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                } else {
+                    escaped += c;
+                }
+            }
+        }
+        return escaped;
+    }
+
+    void Profiler::exportChromeTrace(std::ostream& out) {
+        out << "{\"traceEvents\":[";
+        auto first = true;
+        for (const auto& event : getEvents()) {
+            if (!first) { out << ","; }
+            first = false;
+            // Chrome trace times are in microseconds
+            out << std::format(
+                "\n{{\"name\":\"{}\",\"cat\":\"ecs\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{},\"args\":{{\"frame\":{}}}}}",
+                escapeJson(event.name ? event.name : ""),
+                static_cast<double>(event.start) / 1000.0,
+                static_cast<double>(event.duration) / 1000.0,
+                event.thread,
+                event.frame);
+        }
+        out << "\n]}\n";
+    }
+
+    void Profiler::exportChromeTrace(const std::string& path) {
+        auto out = std::ofstream{path};
+        exportChromeTrace(out);
+    }
+
+}
@@ -0,0 +1,139 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module lysa.ecs.profiler;
+
+import std;
+import lysa.types;
+
+export namespace lysa::ecs {
+
+#ifdef ECS_PROFILER
+    constexpr bool PROFILER_ENABLED{true};
+#else
+    constexpr bool PROFILER_ENABLED{false};
+#endif
+
+    /**
+     * One timed scope recorded by the profiler
+     */
+    struct ProfilerEvent {
+        //! Static name of the scope
+        const char* name{nullptr};
+        //! Frame in which the scope was recorded
+        uint64 frame{0};
+        //! Start time in nanoseconds since the profiler start
+        uint64 start{0};
+        //! Duration in nanoseconds
+        uint64 duration{0};
+        //! Index of the recording thread
+        uint32 thread{0};
+    };
+
+    /**
+     * Per-frame statistics of a scope
+     */
+    struct ProfilerStat {
+        const char* name{nullptr};
+        //! Number of invocations in the frame
+        uint64 count{0};
+        //! Total duration in nanoseconds
+        uint64 duration{0};
+    };
+
+    /**
+     * Records the timed scopes of the systems, observers and loaders into a lock-free ring buffer.
+     *
+     * Only available when the library is built with ECS_PROFILER, otherwise all the scopes compile to nothing.
+     */
+    class Profiler {
+    public:
+        //! Number of events kept in the ring buffer
+        static constexpr uint64 CAPACITY{1 << 16};
+
+        /**
+         * Starts a new frame, called by ecs::progress()
+         */
+        static void beginFrame();
+
+        /**
+         * Returns the current frame number
+         */
+        static uint64 getFrame();
+
+        /**
+         * Returns the time in nanoseconds since the profiler start
+         */
+        static uint64 now();
+
+        /**
+         * Records a scope, can be called from any thread
+         */
+        static void record(const char* name, uint64 start, uint64 duration);
+
+        /**
+         * Returns the events still in the ring buffer, oldest first
+         */
+        static std::vector<ProfilerEvent> getEvents();
+
+        /**
+         * Returns the durations and invocation counts of the scopes recorded during a frame,
+         * by default the last completed frame
+         */
+        static std::vector<ProfilerStat> getFrameStats(uint64 frame = 0);
+
+        /**
+         * Writes the events still in the ring buffer in the Chrome trace JSON format
+         * (chrome://tracing, Perfetto)
+         */
+        static void exportChromeTrace(std::ostream& out);
+
+        /**
+         * Writes the events still in the ring buffer in a Chrome trace JSON file
+         */
+        static void exportChromeTrace(const std::string& path);
+    };
+
+    /**
+     * RAII timer recording the lifetime of the scope in the Profiler
+     */
+    class ProfilerScope {
+    public:
+        explicit ProfilerScope(const char* name) {
+            if constexpr (PROFILER_ENABLED) {
+                this->name = name;
+                start = Profiler::now();
+            }
+        }
+
+        ~ProfilerScope() {
+            if constexpr (PROFILER_ENABLED) {
+                Profiler::record(name, start, Profiler::now() - start);
+            }
+        }
+
+        ProfilerScope(const ProfilerScope&) = delete;
+        ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+    private:
+        const char* name{nullptr};
+        uint64 start{0};
+    };
+
+    /**
+     * Returns a flecs run callback recording one scope per invocation of a system or an observer,
+     * the iterator is forwarded to the each callback given with it to run()
+     */
+    inline auto profileRun(const char* name) {
+        return [name](auto& it) {
+            const auto profile = ProfilerScope{name};
+            while (it.next()) {
+                it.each();
+            }
+        };
+    }
+
+}
@@ -0,0 +1,320 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+module lysa.ecs.snapshot;
+
+import lysa.math;
+import lysa.types;
+import lysa.ecs.components;
+import lysa.ecs.loader;
+import lysa.ecs.profiler;
+import lysa.ecs.systems;
+
+namespace lysa::ecs {
+
+    static constexpr auto SNAPSHOT_MAGIC = std::array{'L', 'E', 'C', 'S'};
+    static constexpr uint32 SNAPSHOT_VERSION{2};
+
+    // Saved components of a group
+    enum SnapshotComponent : uint32 {
+        SNAPSHOT_VISIBLE        = 1 << 0,
+        SNAPSHOT_CAST_SHADOWS   = 1 << 1,
+        SNAPSHOT_TRANSFORM      = 1 << 2,
+        SNAPSHOT_MESH_INSTANCE  = 1 << 3,
+        SNAPSHOT_CAMERA         = 1 << 4,
+        SNAPSHOT_NAME           = 1 << 5,
+    };
+
+    struct SnapshotHeader {
+        std::array<char, 4> magic;
+        uint32 version;
+    };
+
+    // Entities of one table with the same parent, followed by their names then by their columns.
+    // The groups are written breadth first, the parents before their children, and end with an empty group
+    struct SnapshotGroup {
+        //! Index of the parent in the saved entities, -1 for the root
+        int32 parent;
+        uint32 count;
+        uint32 components;
+    };
+
+    template <typename T>
+    static void write(std::ostream& out, const T* data, const size_t count) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+    }
+
+    template <typename T>
+    static void read(std::istream& in, T* data, const size_t count) {
+        in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(sizeof(T) * count));
+        if (!in) {
+            throw std::runtime_error("Truncated ECS snapshot");
+        }
+    }
+
+    // Returns the size of the stream, the maximum when the stream can't seek
+    static std::streamoff streamSize(std::istream& in) {
+        const auto position = in.tellg();
+        if (position == std::streampos(-1)) { return std::numeric_limits<std::streamoff>::max(); }
+        in.seekg(0, std::ios::end);
+        const auto end = in.tellg();
+        in.seekg(position);
+        return end;
+    }
+
+    // The components are written field by field, without the padding of the structures
+    // and without the runtime resources ids
+
+    static_assert(sizeof(float4x4) == 16 * sizeof(float));
+
+    static void writeTransform(std::ostream& out, const Transform& transform) {
+        // the world transform is recomputed from the root on restore
+        write(out, &transform.local, 1);
+    }
+
+    static void readTransform(std::istream& in, Transform& transform) {
+        read(in, &transform.local, 1);
+    }
+
+    static constexpr std::streamoff CAMERA_SIZE = sizeof(uint8) + 8 * sizeof(float);
+
+    static void writeCamera(std::ostream& out, const Camera& camera) {
+        const auto isPerspective = static_cast<uint8>(camera.isPerspective);
+        write(out, &isPerspective, 1);
+        const auto values = std::array{
+            camera.fov, camera.aspectRatio, camera.near, camera.far,
+            camera.left, camera.right, camera.top, camera.bottom};
+        write(out, values.data(), values.size());
+    }
+
+    static void readCamera(std::istream& in, Camera& camera) {
+        auto isPerspective = uint8{0};
+        read(in, &isPerspective, 1);
+        auto values = std::array<float, 8>{};
+        read(in, values.data(), values.size());
+        camera.isPerspective = isPerspective != 0;
+        camera.fov = values[0];
+        camera.aspectRatio = values[1];
+        camera.near = values[2];
+        camera.far = values[3];
+        camera.left = values[4];
+        camera.right = values[5];
+        camera.top = values[6];
+        camera.bottom = values[7];
+    }
+
+    void Snapshot::save(const flecs::entity& root, std::ostream& out) {
+        const auto profile = ProfilerScope{"ecs.snapshot.save"};
+        const auto world = root.world();
+        const auto header = SnapshotHeader{SNAPSHOT_MAGIC, SNAPSHOT_VERSION};
+        write(out, &header, 1);
+        // root then the saved entities, in the order of the snapshot
+        auto parents = std::vector<flecs::entity_t>{root.id()};
+        auto meshes = std::vector<unique_id>{};
+        for (auto parentIndex = 0; parentIndex < parents.size(); ++parentIndex) {
+            auto it = ecs_children(world.c_ptr(), parents[parentIndex]);
+            while (ecs_children_next(&it)) {
+                auto iter = flecs::iter(&it);
+                const auto range = iter.range();
+                if (range.has(flecs::Prefab)) { continue; }
+                auto group = SnapshotGroup{parentIndex - 1, static_cast<uint32>(iter.count()), 0};
+                if (range.has<Visible>()) { group.components |= SNAPSHOT_VISIBLE; }
+                if (range.has<CastShadows>()) { group.components |= SNAPSHOT_CAST_SHADOWS; }
+                if (range.has<Transform>()) { group.components |= SNAPSHOT_TRANSFORM; }
+                if (range.has<MeshInstance>()) { group.components |= SNAPSHOT_MESH_INSTANCE; }
+                if (range.has<Camera>()) { group.components |= SNAPSHOT_CAMERA; }
+                if (range.has(world.pair<flecs::Identifier>(flecs::Name))) { group.components |= SNAPSHOT_NAME; }
+                write(out, &group, 1);
+
+                if (group.components & SNAPSHOT_NAME) {
+                    for (auto i = 0; i < group.count; ++i) {
+                        const auto name = iter.entity(i).name();
+                        const auto length = static_cast<uint32>(name.length());
+                        write(out, &length, 1);
+                        write(out, name.c_str(), length);
+                    }
+                }
+                if (group.components & SNAPSHOT_TRANSFORM) {
+                    const auto* transforms = range.get<Transform>();
+                    for (auto i = 0; i < group.count; ++i) {
+                        writeTransform(out, transforms[i]);
+                    }
+                }
+                if (group.components & SNAPSHOT_MESH_INSTANCE) {
+                    // the mesh instances are runtime resources, only the meshes are saved
+                    const auto* meshInstances = range.get<MeshInstance>();
+                    meshes.clear();
+                    for (auto i = 0; i < group.count; ++i) {
+                        meshes.push_back(meshInstances[i].mesh);
+                    }
+                    write(out, meshes.data(), group.count);
+                }
+                if (group.components & SNAPSHOT_CAMERA) {
+                    const auto* cameras = range.get<Camera>();
+                    for (auto i = 0; i < group.count; ++i) {
+                        writeCamera(out, cameras[i]);
+                    }
+                }
+                for (auto i = 0; i < group.count; ++i) {
+                    parents.push_back(iter.entity(i).id());
+                }
+            }
+        }
+        const auto end = SnapshotGroup{-1, 0, 0};
+        write(out, &end, 1);
+    }
+
+    void Snapshot::save(const flecs::entity& root, const std::string& path) {
+        auto out = std::ofstream{path, std::ios::binary};
+        save(root, out);
+    }
+
+    void Snapshot::restore(const flecs::entity& root, std::istream& in) {
+        const auto profile = ProfilerScope{"ecs.snapshot.restore"};
+        auto header = SnapshotHeader{};
+        read(in, &header, 1);
+        if (header.magic != SNAPSHOT_MAGIC) {
+            throw std::runtime_error("Not an ECS snapshot");
+        }
+        if (header.version != SNAPSHOT_VERSION) {
+            throw std::runtime_error(std::format(
+                "Unsupported ECS snapshot version {}, expected {}", header.version, SNAPSHOT_VERSION));
+        }
+        const auto size = streamSize(in);
+        const auto remainingBytes = [&] {
+            return size == std::numeric_limits<std::streamoff>::max() ? size : size - static_cast<std::streamoff>(in.tellg());
+        };
+        const auto world = root.world();
+        const auto rootGlobal = root.has<Transform>() ? root.get<Transform>().global : float4x4::identity();
+        auto entities = std::vector<flecs::entity_t>{};
+        auto globals = std::vector<float4x4>{};
+        auto topEntities = std::vector<flecs::entity_t>{};
+        // Names given to the children of each parent, the restored names are suffixed when already used
+        auto siblingNames = std::unordered_map<flecs::entity_t, std::unordered_set<std::string>>{};
+        auto names = std::vector<std::string>{};
+        auto transforms = std::vector<Transform>{};
+        auto meshes = std::vector<unique_id>{};
+        auto meshInstances = std::vector<MeshInstance>{};
+        auto cameras = std::vector<Camera>{};
+
+        // The mesh instances are created and added to the scene once, after the last group
+        auto& meshInstanceModule = world.get_mut<MeshInstanceModule>();
+        {
+            const auto suspension = MeshInstanceModule::Suspension{meshInstanceModule};
+            auto group = SnapshotGroup{};
+            for (read(in, &group, 1); group.count > 0; read(in, &group, 1)) {
+                if (group.parent < -1 || group.parent >= static_cast<int32>(entities.size())) {
+                    throw std::runtime_error("Invalid ECS snapshot");
+                }
+                // Bytes read for each entity of the group : a corrupted count must not allocate more
+                // entities than the stream can describe. The groups without saved data are not checked
+                auto entitySize = std::streamoff{0};
+                if (group.components & SNAPSHOT_NAME) { entitySize += sizeof(uint32); }
+                if (group.components & SNAPSHOT_TRANSFORM) { entitySize += sizeof(float4x4); }
+                if (group.components & SNAPSHOT_MESH_INSTANCE) { entitySize += sizeof(unique_id); }
+                if (group.components & SNAPSHOT_CAMERA) { entitySize += CAMERA_SIZE; }
+                auto remaining = remainingBytes();
+                if (entitySize > 0 && static_cast<std::streamoff>(group.count) > remaining / entitySize) {
+                    throw std::runtime_error("Truncated ECS snapshot");
+                }
+                const auto parent = group.parent == -1 ? root.id() : entities[group.parent];
+                const auto& parentGlobal = group.parent == -1 ? rootGlobal : globals[group.parent];
+
+                if (group.components & SNAPSHOT_NAME) {
+                    names.resize(group.count);
+                    for (auto& name : names) {
+                        auto length = uint32{0};
+                        read(in, &length, 1);
+                        if (static_cast<std::streamoff>(length) > remaining) {
+                            throw std::runtime_error("Truncated ECS snapshot");
+                        }
+                        remaining -= length;
+                        name.resize(length);
+                        read(in, name.data(), length);
+                    }
+                }
+                if (group.components & SNAPSHOT_TRANSFORM) {
+                    transforms.resize(group.count);
+                    for (auto& transform : transforms) {
+                        readTransform(in, transform);
+                        transform.global = mul(transform.local, parentGlobal);
+                    }
+                }
+                meshInstances.clear();
+                if (group.components & SNAPSHOT_MESH_INSTANCE) {
+                    meshes.resize(group.count);
+                    read(in, meshes.data(), group.count);
+                    for (const auto mesh : meshes) {
+                        meshInstances.push_back({.mesh = mesh});
+                    }
+                }
+                if (group.components & SNAPSHOT_CAMERA) {
+                    cameras.resize(group.count);
+                    for (auto& camera : cameras) {
+                        readCamera(in, camera);
+                    }
+                }
+
+                auto desc = ecs_bulk_desc_t{};
+                auto data = std::array<void*, 8>{};
+                auto idCount = 0;
+                if (group.components & SNAPSHOT_VISIBLE) {
+                    desc.ids[idCount++] = world.id<Visible>();
+                }
+                if (group.components & SNAPSHOT_CAST_SHADOWS) {
+                    desc.ids[idCount++] = world.id<CastShadows>();
+                }
+                if (group.components & SNAPSHOT_TRANSFORM) {
+                    data[idCount] = transforms.data();
+                    desc.ids[idCount++] = world.id<Transform>();
+                }
+                if (group.components & SNAPSHOT_MESH_INSTANCE) {
+                    data[idCount] = meshInstances.data();
+                    desc.ids[idCount++] = world.id<MeshInstance>();
+                }
+                if (group.components & SNAPSHOT_CAMERA) {
+                    // added without value, the camera resource is created by the observers
+                    desc.ids[idCount++] = world.id<Camera>();
+                }
+                desc.ids[idCount++] = world.pair(flecs::ChildOf, parent);
+                if (group.components & SNAPSHOT_NAME) {
+                    desc.ids[idCount++] = world.pair<flecs::Identifier>(flecs::Name);
+                }
+                desc.count = static_cast<int32>(group.count);
+                desc.data = data.data();
+                const auto* created = ecs_bulk_init(world.c_ptr(), &desc);
+
+                for (auto i = 0; i < group.count; ++i) {
+                    const auto e = flecs::entity(world, created[i]);
+                    entities.push_back(created[i]);
+                    globals.push_back(group.components & SNAPSHOT_TRANSFORM ? transforms[i].global : float4x4::identity());
+                    if (group.parent == -1) {
+                        topEntities.push_back(created[i]);
+                    }
+                    if ((group.components & SNAPSHOT_NAME) && !names[i].empty()) {
+                        const auto parentEntity = flecs::entity(world, parent);
+                        e.set_name(uniqueChildName(parentEntity, names[i], siblingNames[parent]).c_str());
+                    }
+                    if (group.components & SNAPSHOT_CAMERA) {
+                        auto& camera = e.get_mut<Camera>();
+                        const auto id = camera.camera;
+                        camera = cameras[i];
+                        camera.camera = id;
+                    }
+                }
+            }
+        }
+        for (const auto e : topEntities) {
+            meshInstanceModule.addInstances(flecs::entity(world, e));
+        }
+    }
+
+    void Snapshot::restore(const flecs::entity& root, const std::string& path) {
+        auto in = std::ifstream{path, std::ios::binary};
+        restore(root, in);
+    }
+
+}
@@ -0,0 +1,46 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+*
+* This software is released under the MIT License.
+* https://opensource.org/licenses/MIT
+*/
+export module lysa.ecs.snapshot;
+
+import std;
+export import lysa.ecs.flecs;
+
+export namespace lysa::ecs {
+
+    /**
+     * Binary snapshot of the entities under a root entity.
+     *
+     * The hierarchy, the names and the Visible, CastShadows, Transform, MeshInstance and Camera components
+     * are written table by table, field by field, the other components are not saved.
+     * The mesh instances reference their meshes by id : a snapshot can only be restored while the same meshes are loaded.
+     */
+    class Snapshot {
+    public:
+        /**
+         * Writes the entities under the root entity
+         */
+        static void save(const flecs::entity& root, std::ostream& out);
+
+        /**
+         * Writes the entities under the root entity in a file
+         */
+        static void save(const flecs::entity& root, const std::string& path);
+
+        /**
+         * Recreates the saved entities under the root entity, one bulk operation per saved table.
+         * The world transforms are recomputed from the root and the mesh instances are added to the scene
+         * once all the entities are created
+         */
+        static void restore(const flecs::entity& root, std::istream& in);
+
+        /**
+         * Recreates the entities saved in a file under the root entity
+         */
+        static void restore(const flecs::entity& root, const std::string& path);
+    };
+
+}
@@ -6,6 +6,7 @@
 */
 export module lysa.ecs.components;
 
+import std;
 import vireo;
 import lysa.aabb;
 import lysa.context;
@@ -27,6 +28,58 @@ export namespace lysa::ecs {
         lysa::Context* ctx;
     };
 
+    /**
+     * How the nodes of the assets packs are named
+     */
+    enum class NodeNames : uint8 {
+        //! Registered in the world names index, the nodes can be found with lookup()
+        Named,
+        //! Stored in a NodeName component pointing into the assets pack, the nodes can be found with findNode()
+        Interned,
+        //! Not stored
+        Unnamed,
+    };
+
+    /**
+     * ECS configuration, stored as a world singleton
+     */
+    struct ECSConfiguration {
+        //! Fixed simulation time step in seconds, 0 to run the simulation phases once per frame
+        float fixedDeltaTime{0.0f};
+        //! Maximum number of simulation steps run in one frame to catch up with the frame time
+        uint32 maxSimulationSteps{5};
+        //! Collect the per-frame runtime metrics (adds wildcard observers counting the component events)
+        bool metrics{false};
+        //! Number of frames of metrics kept for ecs::dumpMetrics()
+        uint32 metricsHistory{600};
+        //! Time budget in microseconds per frame to create the nodes of the asynchronous loads, 0 for unlimited
+        uint32 loadTimeBudget{2000};
+        //! Maximum number of nodes created per frame by the asynchronous loads, 0 for unlimited
+        uint32 loadNodesBudget{0};
+        //! Maximum number of streaming cells being loaded at the same time
+        uint32 streamingMaxPendingLoads{2};
+        //! Naming of the loaded nodes, the world names index costs a hash insert and a string allocation per node
+        NodeNames loadNodeNames{NodeNames::Named};
+        //! Queue the add, remove, child_of and destruct calls made from Lua and merge them once per frame.
+        //! The has() calls and the properties read from Lua don't see the pending changes until the merge
+        bool luaDeferredCommands{false};
+        //! Time budget in microseconds per frame to resume the Lua behaviors, 0 for unlimited
+        uint32 luaBehaviorsBudget{1000};
+    };
+
+    /**
+     * Simulation clock, stored as a world singleton and updated before each simulation step,
+     * then once more before the default pipeline with the interpolation factor of the frame
+     */
+    struct SimulationTime {
+        //! Time step of the simulation phases in seconds
+        float deltaTime{0.0f};
+        //! Fraction of a simulation step elapsed since the last step, used to interpolate the presentation
+        float alpha{1.0f};
+        //! Number of simulation steps run since the start
+        uint64 ticks{0};
+    };
+
 #ifdef LUA_BINDING
     struct Lua {
         const lysa::Lua* lua;
@@ -75,6 +128,33 @@ export namespace lysa::ecs {
         flecs::entity camera;
     };
 
+    /**
+     * Cell of a streamed world.
+     * The assets pack is loaded under the entity when a camera comes closer than loadDistance to the cell bounds
+     * and unloaded when all the cameras are farther than unloadDistance
+     */
+    struct StreamingCell {
+        //! URI of the assets pack
+        std::string uri;
+        //! World space bounds of the cell
+        float3 min{0.0f};
+        float3 max{0.0f};
+        float loadDistance{100.0f};
+        //! Greater than loadDistance so a camera moving along the limit does not reload the cell each frame
+        float unloadDistance{120.0f};
+    };
+
+    /**
+     * Name of a node loaded with NodeNames::Interned,
+     * the string is owned by the RetainedNodes component of the load root
+     */
+    struct NodeName {
+        const char* name{nullptr};
+    };
+
+    //! Tag of the streaming cells loaded or being loaded
+    struct StreamedIn {};
+
     struct MaterialOverride {
         uint32 surfaceIndex;
         unique_id material;
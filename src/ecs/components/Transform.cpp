@@ -51,6 +51,41 @@ namespace lysa::ecs {
         e.add<TransformUpdated>();
     }
 
+    std::vector<float3> getPositions(const std::span<const flecs::entity> entities) {
+        auto positions = std::vector<float3>{};
+        positions.reserve(entities.size());
+        for (const auto& e : entities) {
+            positions.push_back(getPosition(e));
+        }
+        return positions;
+    }
+
+    void setPositions(const std::span<const flecs::entity> entities, const std::span<const float3> positions) {
+        assert([&]{ return entities.size() == positions.size(); }, "One position per entity expected");
+        if (entities.empty()) { return; }
+        const auto defer = DeferScope{entities.front().world()};
+        for (auto i = 0; i < entities.size(); ++i) {
+            setPosition(entities[i], positions[i]);
+        }
+    }
+
+    void translate(const std::span<const flecs::entity> entities, const float3& localOffset) {
+        if (entities.empty()) { return; }
+        const auto defer = DeferScope{entities.front().world()};
+        for (const auto& e : entities) {
+            translate(e, localOffset);
+        }
+    }
+
+    void translate(const std::span<const flecs::entity> entities, const std::span<const float3> localOffsets) {
+        assert([&]{ return entities.size() == localOffsets.size(); }, "One offset per entity expected");
+        if (entities.empty()) { return; }
+        const auto defer = DeferScope{entities.front().world()};
+        for (auto i = 0; i < entities.size(); ++i) {
+            translate(entities[i], localOffsets[i]);
+        }
+    }
+
     void scale(const flecs::entity& e, const float& scale) {
         CHECK_TRANSFORM(e);
         auto& t = e.get_mut<Transform>();
@@ -6,6 +6,7 @@
 */
 export module lysa.ecs.components.transform;
 
+import std;
 import lysa.exception;
 import lysa.math;
 import lysa.ecs.flecs;
@@ -25,6 +26,32 @@ export namespace lysa::ecs {
 
     struct TransformUpdated {};
 
+    /**
+     * Smooths the world transform between two fixed simulation steps.
+     *
+     * The world transforms of the last two simulation steps are decomposed once per step
+     * and blended each frame (lerp of position and scale, slerp of rotation) using SimulationTime::alpha.
+     * When present, the blended transform is used by the mesh instances and cameras instead of Transform::global
+     */
+    struct TransformInterpolation {
+        /** Decomposed world space transform */
+        struct Pose {
+            float3 position{0.0f};
+            quaternion rotation{};
+            float3 scale{1.0f};
+        };
+        /** World space transform at the previous simulation step */
+        Pose previous;
+        /** World space transform at the last simulation step */
+        Pose current;
+        /** World space transform matrix at the last simulation step */
+        float4x4 target{float4x4::identity()};
+        /** False when the last simulation step did not change the world transform */
+        bool moving{false};
+        /** Blended world space transform matrix used for the presentation */
+        float4x4 global{float4x4::identity()};
+    };
+
     /**
     * Returns the world space position
     */
@@ -71,6 +98,28 @@ export namespace lysa::ecs {
         translate(e, float3{localOffsetX, localOffsetY, localOffsetZ});
     }
 
+    /**
+    * Returns the local space positions of several entities
+    */
+    std::vector<float3> getPositions(std::span<const flecs::entity> entities);
+
+    /**
+    * Sets the local space positions of several entities, the transforms updates are merged in one batch
+    */
+    void setPositions(std::span<const flecs::entity> entities, std::span<const float3> positions);
+
+    /**
+    * Changes the positions of several entities by the same offset vector in local space,
+    * the transforms updates are merged in one batch
+    */
+    void translate(std::span<const flecs::entity> entities, const float3& localOffset);
+
+    /**
+    * Changes the positions of several entities by one offset vector per entity in local space,
+    * the transforms updates are merged in one batch
+    */
+    void translate(std::span<const flecs::entity> entities, std::span<const float3> localOffsets);
+
     /**
     * Scale the local transformation
     */
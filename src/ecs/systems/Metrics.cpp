@@ -0,0 +1,109 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+*/
+module lysa.ecs.systems;
+
+namespace lysa::ecs {
+
+     MetricsModule::MetricsModule(const flecs::world& w):
+          stats(std::make_unique<ecs_world_stats_t>()),
+          historySize(w.get<ECSConfiguration>().metricsHistory) {
+          w.module<MetricsModule>();
+          // The added components are received in the destination table, the removed ones in the source table
+          const auto count = [this](flecs::iter& it, const size_t i) {
+               if (it.event() == flecs::OnAdd) {
+                    onAddEvents += 1;
+                    countMove(it.entity(i), it.c_ptr()->other_table, it.c_ptr()->table);
+               } else if (it.event() == flecs::OnRemove) {
+                    onRemoveEvents += 1;
+                    countMove(it.entity(i), it.c_ptr()->table, it.c_ptr()->other_table);
+               } else {
+                    onSetEvents += 1;
+               }
+          };
+          w.observer()
+             .with(flecs::Wildcard)
+             .event(flecs::OnAdd)
+             .event(flecs::OnRemove)
+             .event(flecs::OnSet)
+             .each(count);
+          w.observer()
+             .with(flecs::Wildcard, flecs::Wildcard)
+             .event(flecs::OnAdd)
+             .event(flecs::OnRemove)
+             .each(count);
+     }
+
+     void MetricsModule::countMove(
+          const flecs::entity_t entity,
+          const flecs::table_t* source,
+          const flecs::table_t* destination) {
+          // Created and deleted entities are not moved
+          if (!source || !destination || source == destination) { return; }
+          if (entity == lastEntity && source == lastSource && destination == lastDestination) { return; }
+          lastEntity = entity;
+          lastSource = source;
+          lastDestination = destination;
+          entitiesMoved += 1;
+     }
+
+     void MetricsModule::sample(const flecs::world& w) {
+          ecs_world_stats_get(w.c_ptr(), stats.get());
+          const auto t = stats->t;
+          const auto rate = [t](const auto& metric) {
+               return static_cast<uint64>(metric.counter.rate.avg[t]);
+          };
+          const auto gauge = [t](const auto& metric) {
+               return static_cast<uint64>(metric.gauge.avg[t]);
+          };
+          const auto& commands = stats->commands;
+          last = {
+               .frame = static_cast<uint64>(w.get_info()->frame_count_total),
+               .onAddEvents = onAddEvents,
+               .onRemoveEvents = onRemoveEvents,
+               .onSetEvents = onSetEvents,
+               .entitiesMoved = entitiesMoved,
+               .observersRan = rate(stats->frame.observers_ran),
+               .eventsEmitted = rate(stats->frame.event_emit_count),
+               .systemsRan = rate(stats->frame.systems_ran),
+               .commandsDeferred =
+                    rate(commands.add_count) + rate(commands.remove_count) +
+                    rate(commands.delete_count) + rate(commands.clear_count) +
+                    rate(commands.set_count) + rate(commands.ensure_count) +
+                    rate(commands.modified_count) + rate(commands.other_count),
+               .commandsBatched = rate(commands.batched_count),
+               .entitiesBatched = rate(commands.batched_entity_count),
+               .commandsDiscarded = rate(commands.discard_count),
+               .merges = rate(stats->frame.merge_count),
+               .tablesCreated = rate(stats->tables.create_count),
+               .tablesDeleted = rate(stats->tables.delete_count),
+               .tableCount = gauge(stats->tables.count),
+               .entityCount = gauge(stats->entities.count),
+          };
+          onAddEvents = 0;
+          onRemoveEvents = 0;
+          onSetEvents = 0;
+          entitiesMoved = 0;
+          lastEntity = 0;
+          history.push_back(last);
+          while (history.size() > historySize) {
+               history.pop_front();
+          }
+     }
+
+     void MetricsModule::dump(std::ostream& out) const {
+          out << "frame,on_add_events,on_remove_events,on_set_events,entities_moved,"
+                 "observers_ran,events_emitted,systems_ran,commands_deferred,commands_batched,entities_batched,"
+                 "commands_discarded,merges,tables_created,tables_deleted,table_count,entity_count\n";
+          for (const auto& m : history) {
+               out << std::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                    m.frame, m.onAddEvents, m.onRemoveEvents, m.onSetEvents, m.entitiesMoved,
+                    m.observersRan, m.eventsEmitted, m.systemsRan, m.commandsDeferred, m.commandsBatched, m.entitiesBatched,
+                    m.commandsDiscarded, m.merges, m.tablesCreated, m.tablesDeleted, m.tableCount, m.entityCount);
+          }
+     }
+
+}
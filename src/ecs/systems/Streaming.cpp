@@ -0,0 +1,85 @@
+/*
+* Copyright (c) 2025-present Henri Michelon
+ *
+ * This software is released under the MIT License.
+ * https://opensource.org/licenses/MIT
+*/
+module lysa.ecs.systems;
+
+import lysa.math;
+import lysa.ecs.loader;
+import lysa.ecs.profiler;
+
+namespace lysa::ecs {
+
+     StreamingModule::StreamingModule(const flecs::world& w) {
+          w.module<StreamingModule>();
+          w.component<StreamingCell>()
+               .member("load_distance", &StreamingCell::loadDistance)
+               .member("unload_distance", &StreamingCell::unloadDistance);
+          w.component<StreamedIn>();
+          w.observer<const StreamingCell>()
+             .event(flecs::OnRemove)
+             .run(profileRun("StreamingModule.OnRemove(StreamingCell)"), [this](const flecs::entity& e, const StreamingCell&) {
+                  if (const auto it = loads.find(e.id()); it != loads.end()) {
+                       it->second->cancel();
+                       loads.erase(it);
+                  }
+             });
+          const auto cameras = w.query<const Camera, const Transform>();
+          w.system<const StreamingCell>()
+             .run([this, cameras](flecs::iter& it) {
+                  const auto profile = ProfilerScope{"StreamingModule.update"};
+                  auto positions = std::vector<float3>{};
+                  cameras.each([&](const Camera&, const Transform& tr) {
+                       positions.push_back(tr.global[3].xyz);
+                  });
+                  struct Candidate {
+                       flecs::entity cell;
+                       float distance;
+                  };
+                  auto candidates = std::vector<Candidate>{};
+                  while (it.next()) {
+                       const auto cells = it.field<const StreamingCell>(0);
+                       const auto streamedIn = it.table().has<StreamedIn>();
+                       for (const auto i : it) {
+                            const auto& cell = cells[i];
+                            // distance from the nearest camera to the cell bounds
+                            auto distance = std::numeric_limits<float>::max();
+                            for (const auto& position : positions) {
+                                 distance = std::min(distance,
+                                      length(max(max(cell.min - position, position - cell.max), float3{0.0f})));
+                            }
+                            if (!streamedIn && distance <= cell.loadDistance) {
+                                 candidates.push_back({it.entity(i), distance});
+                            } else if (streamedIn && distance > cell.unloadDistance) {
+                                 unload(it.entity(i));
+                            }
+                       }
+                  }
+                  std::erase_if(loads, [](const auto& load) {
+                       return load.second->isLoaded() || load.second->isFailed();
+                  });
+                  std::ranges::sort(candidates, {}, &Candidate::distance);
+                  const auto maxPendingLoads = it.world().get<ECSConfiguration>().streamingMaxPendingLoads;
+                  for (const auto& candidate : candidates) {
+                       if (loads.size() >= maxPendingLoads) { break; }
+                       loads[candidate.cell.id()] = loadAsync(candidate.cell, candidate.cell.get<StreamingCell>().uri);
+                       candidate.cell.add<StreamedIn>();
+                  }
+             });
+     }
+
+     void StreamingModule::unload(const flecs::entity& cell) {
+          if (const auto it = loads.find(cell.id()); it != loads.end()) {
+               it->second->cancel();
+               loads.erase(it);
+          }
+          // The whole subtree is deleted table by table instead of entity by entity
+          cell.world().delete_with(flecs::ChildOf, cell);
+          // The cell is kept for the next load, the interned names of the deleted nodes are released now
+          cell.remove<RetainedNodes>();
+          cell.remove<StreamedIn>();
+     }
+
+}
@@ -12,18 +12,54 @@ import lysa.math;
 import lysa.resources.camera;
 import lysa.resources.render_target;
 import lysa.renderers.graphic_pipeline_data;
+import lysa.ecs.profiler;
 
 namespace lysa::ecs {
     Modules::Modules(flecs::world& w) {
+        pipelineModule = w.import<PipelineModule>();
+        simulationPipeline = w.pipeline()
+            .with(flecs::System)
+            .with<SimulationPhase>().cascade(flecs::DependsOn)
+            .without(flecs::Disabled).up(flecs::DependsOn)
+            .without(flecs::Disabled).up(flecs::ChildOf)
+            .order_by(0, [](const flecs::entity_t e1, const void*, const flecs::entity_t e2, const void*) {
+                return (e1 > e2) - (e1 < e2);
+            })
+            .build();
+        if (w.get<ECSConfiguration>().metrics) {
+            metricsModule = w.import<MetricsModule>();
+        }
         meshInstanceModule = w.import<MeshInstanceModule>();
         renderModule = w.import<RenderModule>();
         transformModule = w.import<TransformModule>();
+        streamingModule = w.import<StreamingModule>();
     }
 
     Modules::~Modules() {
+        streamingModule.disable();
         transformModule.disable();
         renderModule.disable();
         meshInstanceModule.disable();
+        if (metricsModule) {
+            metricsModule.disable();
+        }
+        pipelineModule.disable();
+    }
+
+    PipelineModule::PipelineModule(const flecs::world& w) {
+        w.module<PipelineModule>();
+        w.component<SimulationPhase>();
+        w.component<SimulationTime>()
+            .member("delta_time", &SimulationTime::deltaTime)
+            .member("alpha", &SimulationTime::alpha)
+            .member("ticks", &SimulationTime::ticks);
+        w.set<SimulationTime>({.deltaTime = w.get<ECSConfiguration>().fixedDeltaTime});
+        // The simulation phases are not flecs::Phase so the default pipeline ignores them
+        w.component<FixedUpdate>()
+            .add<SimulationPhase>();
+        w.component<FixedPostUpdate>()
+            .add<SimulationPhase>()
+            .depends_on<FixedUpdate>();
     }
 
     void MeshInstanceModule::createInstance(
@@ -51,10 +87,23 @@ namespace lysa::ecs {
             sceneContextManager[sc.context].addInstance(mi.mesh_instance, false);
         }
         e.children([&](const flecs::entity& child) {
-            addInstance(child, sc, tr);
+            addInstance(child, sc, child.has<Transform>() ? child.get<Transform>() : tr);
         });
     }
 
+    void MeshInstanceModule::addInstances(const flecs::entity& e) const {
+        if (!e.has<Transform>()) { return; }
+        for (auto parent = e.parent(); parent; parent = parent.parent()) {
+            if (parent.has<Scene>()) {
+                const auto& sc = parent.get<Scene>();
+                if (sc.context != INVALID_ID) {
+                    addInstance(e, sc, e.get<Transform>());
+                }
+                return;
+            }
+        }
+    }
+
     MeshInstanceModule::MeshInstanceModule(const flecs::world& w):
         meshManager(w.get<Context>().ctx->res.get<MeshManager>()),
         meshInstanceManager(w.get<Context>().ctx->res.get<MeshInstanceManager>()),
@@ -62,11 +111,16 @@ namespace lysa::ecs {
         w.module<MeshInstanceModule>();
         w.component<Visible>();
         w.component<CastShadows>();
-        w.component<MeshInstance>();
+        // mesh_instance is the runtime handle created by the observers, it is not described
+        w.component<MeshInstance>()
+            .member("mesh", &MeshInstance::mesh);
+        w.component<MaterialOverride>()
+            .member("surface_index", &MaterialOverride::surfaceIndex)
+            .member("material", &MaterialOverride::material);
         w.observer<const Scene, const MeshInstance>()
             .term_at(0).parent()
             .event(flecs::OnSet)
-            .each([&](const flecs::entity& e, const Scene&sc, const MeshInstance& mi) {
+            .run(profileRun("MeshInstanceModule.OnSet(Scene, MeshInstance)"), [&](const flecs::entity& e, const Scene&sc, const MeshInstance& mi) {
                 if (mi.mesh == INVALID_ID || mi.mesh_instance == INVALID_ID || sc.context == INVALID_ID) { return; }
                 e.add<Updated>();
             });
@@ -74,30 +128,32 @@ namespace lysa::ecs {
             .term_at(0).parent()
             .event(flecs::OnSet)
             .event(flecs::OnAdd)
-            .each([&](const flecs::entity& e, const Scene&sc, const MeshInstance& mi, Transform& tr) {
-                if (mi.mesh == INVALID_ID || sc.context == INVALID_ID) { return; }
+            .run(profileRun("MeshInstanceModule.OnAdd|OnSet(Scene, MeshInstance, Transform)"), [&](const flecs::entity& e, const Scene&sc, const MeshInstance& mi, Transform& tr) {
+                if (suspended > 0 || mi.mesh == INVALID_ID || sc.context == INVALID_ID) { return; }
                 // TransformModule::updateGlobalTransform(e, tr);
                 addInstance(e, sc, tr);
             });
         w.observer<const Scene, Transform>()
             .term_at(0).parent()
             .event(flecs::OnSet)
-            .each([&](const flecs::entity& e, const Scene& sc, Transform& tr) {
-                if (sc.context == INVALID_ID ) { return; }
+            .run(profileRun("MeshInstanceModule.OnSet(Scene, Transform)"), [&](const flecs::entity& e, const Scene& sc, Transform& tr) {
+                if (suspended > 0 || sc.context == INVALID_ID ) { return; }
                 //TransformModule::updateGlobalTransform(e, tr);
                 addInstance(e, sc, tr);
             });
         w.observer<MeshInstance>()
             .event(flecs::OnRemove)
             .with(flecs::Prefab)
-            .each([&](MeshInstance& mi) {
+            .run(profileRun("MeshInstanceModule.OnRemove(Prefab MeshInstance)"), [&](MeshInstance& mi) {
+                // the prefabs of the loader cache have no mesh instances
+                if (mi.mesh_instance == INVALID_ID) { return; }
                 meshInstanceManager.destroy(mi.mesh_instance);
                 mi.mesh_instance = INVALID_ID;
                 mi.mesh = INVALID_ID;
             });
         w.observer<MeshInstance>()
             .event(flecs::OnRemove)
-            .each([&](MeshInstance& mi) {
+            .run(profileRun("MeshInstanceModule.OnRemove(MeshInstance)"), [&](MeshInstance& mi) {
                 meshInstanceManager.destroy(mi.mesh_instance);
                 mi.mesh_instance = INVALID_ID;
                 mi.mesh = INVALID_ID;
@@ -105,7 +161,7 @@ namespace lysa::ecs {
         w.observer<const Scene, const MeshInstance, const Transform>()
             .term_at(0).parent()
             .event(flecs::OnRemove)
-            .each([&](const flecs::entity& e, const Scene& sc, const MeshInstance& mi, const Transform&) {
+            .run(profileRun("MeshInstanceModule.OnRemove(Scene, MeshInstance, Transform)"), [&](const flecs::entity& e, const Scene& sc, const MeshInstance& mi, const Transform&) {
                 if (mi.mesh != INVALID_ID && mi.mesh_instance != INVALID_ID) {
                     auto& scene = sceneContextManager[sc.context];
                     scene.removeInstance(mi.mesh_instance, false);
@@ -120,7 +176,7 @@ namespace lysa::ecs {
             .term_at(0).parent()
             .event(flecs::OnAdd)
             .event(flecs::OnRemove)
-            .each([&](const flecs::entity& e, const Scene&, const MeshInstance& mi, const Visible&) {
+            .run(profileRun("MeshInstanceModule.OnAdd|OnRemove(Scene, MeshInstance, Visible)"), [&](const flecs::entity& e, const Scene&, const MeshInstance& mi, const Visible&) {
                if (mi.mesh != INVALID_ID && mi.mesh_instance != INVALID_ID) {
                    e.add<Updated>();
                }
@@ -128,7 +184,7 @@ namespace lysa::ecs {
         w.observer<const Scene, MeshInstance, const MaterialOverride>()
             .term_at(0).parent()
             .event(flecs::OnSet)
-            .each([&](const Scene&sc, const MeshInstance& mi, const MaterialOverride&mo) {
+            .run(profileRun("MeshInstanceModule.OnSet(Scene, MeshInstance, MaterialOverride)"), [&](const Scene&sc, const MeshInstance& mi, const MaterialOverride&mo) {
                if (mi.mesh != INVALID_ID && mi.mesh_instance != INVALID_ID) {
                     auto& scene = sceneContextManager[sc.context];
                     auto& newMeshInstance = meshInstanceManager[mi.mesh_instance];
@@ -140,7 +196,7 @@ namespace lysa::ecs {
         w.observer<const Scene, MeshInstance, const MaterialOverride>()
             .term_at(0).parent()
             .event(flecs::OnRemove)
-            .each([&](const Scene&sc, const MeshInstance& mi, const MaterialOverride&mo) {
+            .run(profileRun("MeshInstanceModule.OnRemove(Scene, MeshInstance, MaterialOverride)"), [&](const Scene&sc, const MeshInstance& mi, const MaterialOverride&mo) {
                if (mi.mesh != INVALID_ID && mi.mesh_instance != INVALID_ID) {
                     auto& scene = sceneContextManager[sc.context];
                     auto& newMeshInstance = meshInstanceManager[mi.mesh_instance];
@@ -149,16 +205,17 @@ namespace lysa::ecs {
                     scene.addInstance(mi.mesh_instance, false);
                }
            });
-        w.system<const Scene, const MeshInstance, const Transform, const Updated>()
+        w.system<const Scene, const MeshInstance, const Transform, const Updated, const TransformInterpolation*>()
             .term_at(0).parent()
             .kind(flecs::OnUpdate)
-            .each([&](const flecs::entity& e, const Scene& sc, const MeshInstance& mi, const Transform& tr, const Updated&) {
+            .run(profileRun("MeshInstanceModule.update"), [&](const flecs::entity& e, const Scene& sc, const MeshInstance& mi, const Transform& tr, const Updated&, const TransformInterpolation* ti) {
                 if (mi.mesh != INVALID_ID && mi.mesh_instance != INVALID_ID) {
                     e.remove<Updated>();
+                    const auto& global = ti ? ti->global : tr.global;
                     auto& meshInstance = meshInstanceManager[mi.mesh_instance];
                     meshInstance.setVisible(e.has<Visible>());
-                    meshInstance.setAABB(meshManager[mi.mesh].getAABB().toGlobal(tr.global));
-                    meshInstance.setTransform(tr.global);
+                    meshInstance.setAABB(meshManager[mi.mesh].getAABB().toGlobal(global));
+                    meshInstance.setTransform(global);
                     auto& scene = sceneContextManager[sc.context];
                     scene.updateInstance(mi.mesh_instance);
                 }
@@ -172,44 +229,57 @@ namespace lysa::ecs {
         w.module<RenderModule>();
         w.component<Scene>();
         w.component<SceneRef>();
-        w.component<Camera>();
+        // The camera resource is not described, it is owned by the observers
+        w.component<Camera>()
+            .member("is_perspective", &Camera::isPerspective)
+            .member("fov", &Camera::fov)
+            .member("aspect_ratio", &Camera::aspectRatio)
+            .member("near", &Camera::near)
+            .member("far", &Camera::far)
+            .member("left", &Camera::left)
+            .member("right", &Camera::right)
+            .member("top", &Camera::top)
+            .member("bottom", &Camera::bottom);
         w.component<CameraRef>();
         w.component<Viewport>();
-        w.component<RenderTarget>();
+        w.component<RenderTarget>()
+            .member("render_target", &RenderTarget::renderTarget);
+        w.component<AmbientLight>()
+            .member("intensity", &AmbientLight::intensity);
         w.observer<Scene, const AmbientLight>()
             .event(flecs::OnSet)
             .event(flecs::OnAdd)
-            .each([&](const Scene& sc, const AmbientLight& al) {
+            .run(profileRun("RenderModule.OnAdd|OnSet(Scene, AmbientLight)"), [&](const Scene& sc, const AmbientLight& al) {
                 auto& scene = sceneContextManager[sc.context];
                 scene.setAmbientLight(float4(al.color, al.intensity));
             });
         w.observer<Scene>()
             .event(flecs::OnAdd)
-            .each([&](Scene&sc) {
+            .run(profileRun("RenderModule.OnAdd(Scene)"), [&](Scene&sc) {
                 sc.context = sceneContextManager.create().id;
             });
         w.observer<const Scene>()
            .event(flecs::OnRemove)
-           .each([&](const Scene&sc) {
+           .run(profileRun("RenderModule.OnRemove(Scene)"), [&](const Scene&sc) {
                sceneContextManager.destroy(sc.context);
            });
         w.observer<Camera, const Transform>()
             .event(flecs::OnAdd)
             .event(flecs::OnSet)
-            .each([&](Camera&c, const Transform&) {
+            .run(profileRun("RenderModule.OnAdd|OnSet(Camera, Transform)"), [&](Camera&c, const Transform&) {
                 if (c.camera == INVALID_ID) {
                     c.camera = cameraManager.create().id;
                 }
             });
         w.observer<const Camera, const Transform>()
            .event(flecs::OnRemove)
-           .each([&](const Camera&c, const Transform&) {
+           .run(profileRun("RenderModule.OnRemove(Camera, Transform)"), [&](const Camera&c, const Transform&) {
                cameraManager.destroy(c.camera);
            });
         w.observer<const RenderTarget, const CameraRef, const SceneRef>()
             .term_at(0).parent()
             .event(flecs::OnSet)
-            .each([&](const flecs::entity e, const RenderTarget&rt, const CameraRef &cr, const SceneRef&sr) {
+            .run(profileRun("RenderModule.OnSet(RenderTarget, CameraRef, SceneRef)"), [&](const flecs::entity e, const RenderTarget&rt, const CameraRef &cr, const SceneRef&sr) {
                 if (!renderTargetManager.have(rt.renderTarget)) return;
                 auto& renderTarget = renderTargetManager[rt.renderTarget];
                 auto& scene = sceneContextManager[sr.scene.get<Scene>().context];
@@ -228,7 +298,7 @@ namespace lysa::ecs {
         });
         w.observer<const Viewport>()
             .event(flecs::OnSet)
-            .each([&](const flecs::entity e, const Viewport vp) {
+            .run(profileRun("RenderModule.OnSet(Viewport)"), [&](const flecs::entity e, const Viewport vp) {
                 if (e.parent() && e.parent().has<RenderTarget>()) {
                     auto& rt = e.parent().get<RenderTarget>();
                     if (!renderTargetManager.have(rt.renderTarget)) return;
@@ -246,7 +316,7 @@ namespace lysa::ecs {
         w.observer<const RenderTarget, const CameraRef, const SceneRef>()
             .term_at(0).parent()
             .event(flecs::OnRemove)
-            .each([&](const flecs::entity e, const RenderTarget&rt, const CameraRef &, const SceneRef&) {
+            .run(profileRun("RenderModule.OnRemove(RenderTarget, CameraRef, SceneRef)"), [&](const flecs::entity e, const RenderTarget&rt, const CameraRef &, const SceneRef&) {
                 if (!renderTargetManager.have(rt.renderTarget)) return;
                 auto& renderTarget = renderTargetManager[rt.renderTarget];
                 const auto id = static_cast<const unique_id>(e.id());
@@ -255,9 +325,10 @@ namespace lysa::ecs {
                     return view.id == id;
                 });
             });
-        w.system<const Camera, const Transform>()
+        w.system<const Camera, const Transform, const TransformInterpolation*>()
             .kind(flecs::OnUpdate)
-            .each([&](const Camera& c, const Transform& tr) {
+            .run(profileRun("RenderModule.updateCamera"), [&](const Camera& c, const Transform& tr, const TransformInterpolation* ti) {
+                const auto& global = ti ? ti->global : tr.global;
                 auto& camera = cameraManager[c.camera];
                 float4x4 projection{float4x4::identity()};
                 if (c.isPerspective) {
@@ -265,15 +336,15 @@ namespace lysa::ecs {
                 } else {
                     projection = orthographic(c.left, c.right, c.top, c.bottom, c.near, c.far);
                 }
-                camera.position =  tr.global[3].xyz;
-                camera.transform = tr.global;
+                camera.position =  global[3].xyz;
+                camera.transform = global;
                 camera.projection = projection;
             });
         w.system<const RenderTarget>()
             .kind(flecs::OnUpdate)
-            .each([&](const RenderTarget& rt) {
-                auto& renderTarget = renderTargetManager[rt.renderTarget];
+            .run(profileRun("RenderModule.render"), [&](const RenderTarget& rt) {
                 if (!renderTargetManager.have(rt.renderTarget)) return;
+                auto& renderTarget = renderTargetManager[rt.renderTarget];
                 renderTarget.render();
             });
 
@@ -8,24 +8,81 @@ export module lysa.ecs.systems;
 
 import std;
 import lysa.types;
+import lysa.math;
 import lysa.resources.mesh;
 import lysa.resources.mesh_instance;
 import lysa.resources.scene_context;
+import lysa.ecs.loader;
 export import lysa.ecs.components;
 export import lysa.ecs.flecs;
 
 export namespace lysa::ecs {
 
+    /**
+     * Tag of the fixed timestep simulation phases.
+     * Systems in those phases are not run by the default pipeline but by the simulation pipeline,
+     * zero or more times per frame depending on ECSConfiguration::fixedDeltaTime
+     */
+    struct SimulationPhase {};
+
+    /**
+     * Fixed timestep phase for the gameplay systems
+     */
+    struct FixedUpdate {};
+
+    /**
+     * Fixed timestep phase running after FixedUpdate
+     */
+    struct FixedPostUpdate {};
+
+    class PipelineModule {
+    public:
+        PipelineModule(const flecs::world& w);
+    };
+
     class TransformModule {
     public:
         TransformModule(const flecs::world& w);
         static void updateGlobalTransform(const flecs::entity& e, Transform& t);
+        static TransformInterpolation::Pose decompose(const float4x4& transform);
+        static float4x4 interpolate(const TransformInterpolation::Pose& from, const TransformInterpolation::Pose& to, float alpha);
     };
 
     class MeshInstanceModule {
     public:
         MeshInstanceModule(const flecs::world& w);
+
+        /**
+         * Suspends the creation of the mesh instances by the Transform and MeshInstance observers,
+         * used while building a subtree to register its instances once with addInstances()
+         */
+        void suspend() { suspended += 1; }
+
+        /**
+         * Resumes the creation of the mesh instances by the observers
+         */
+        void resume() { suspended -= 1; }
+
+        /**
+         * Suspends the creation of the mesh instances for the lifetime of the scope
+         */
+        class Suspension {
+        public:
+            explicit Suspension(MeshInstanceModule& module): module(module) { module.suspend(); }
+            ~Suspension() { module.resume(); }
+            Suspension(const Suspension&) = delete;
+            Suspension& operator=(const Suspension&) = delete;
+        private:
+            MeshInstanceModule& module;
+        };
+
+        /**
+         * Creates and adds to the scene the mesh instances of a subtree, once per entity
+         */
+        void addInstances(const flecs::entity& e) const;
+
     private:
+        uint32 suspended{0};
         MeshManager& meshManager;
         MeshInstanceManager& meshInstanceManager;
         SceneContextManager& sceneContextManager;
@@ -43,14 +100,122 @@ export namespace lysa::ecs {
         RenderModule(const flecs::world& w);
     };
 
+    /**
+     * Loads and unloads the StreamingCell entities depending on their distance to the cameras,
+     * the nearest cells first
+     */
+    class StreamingModule {
+    public:
+        StreamingModule(const flecs::world& w);
+
+    private:
+        std::unordered_map<flecs::entity_t, std::shared_ptr<AsyncLoad>> loads;
+
+        void unload(const flecs::entity& cell);
+    };
+
+    /**
+     * Runtime metrics of one frame
+     */
+    struct ECSMetrics {
+        //! Frame number
+        uint64 frame{0};
+        //! OnAdd events, one per entity and component
+        uint64 onAddEvents{0};
+        //! OnRemove events, one per entity and component
+        uint64 onRemoveEvents{0};
+        //! OnSet events, one per entity and component
+        uint64 onSetEvents{0};
+        //! Entities moved from one table to another, one per move even when it adds and removes several components
+        uint64 entitiesMoved{0};
+        //! Observer invocations for all the event types
+        uint64 observersRan{0};
+        //! Events emitted
+        uint64 eventsEmitted{0};
+        //! Systems ran
+        uint64 systemsRan{0};
+        //! Commands deferred then merged
+        uint64 commandsDeferred{0};
+        //! Commands batched during the merges
+        uint64 commandsBatched{0};
+        //! Entities whose batched commands were merged with a single table move
+        uint64 entitiesBatched{0};
+        //! Commands discarded because the entity was no longer alive
+        uint64 commandsDiscarded{0};
+        //! Deferred commands merges
+        uint64 merges{0};
+        //! Tables created
+        uint64 tablesCreated{0};
+        //! Tables deleted
+        uint64 tablesDeleted{0};
+        //! Number of tables at the end of the frame
+        uint64 tableCount{0};
+        //! Number of entities at the end of the frame
+        uint64 entityCount{0};
+    };
+
+    /**
+     * Collects the ECSMetrics from the flecs statistics addon and from wildcard observers
+     */
+    class MetricsModule {
+    public:
+        MetricsModule(const flecs::world& w);
+
+        /**
+         * Samples the statistics of the frame that just ended
+         */
+        void sample(const flecs::world& w);
+
+        /**
+         * Returns the metrics of the last sampled frame
+         */
+        const ECSMetrics& getLast() const { return last; }
+
+        /**
+         * Returns the metrics of the last frames, oldest first
+         */
+        const std::deque<ECSMetrics>& getHistory() const { return history; }
+
+        /**
+         * Writes the metrics history in the CSV format
+         */
+        void dump(std::ostream& out) const;
+
+    private:
+        std::unique_ptr<ecs_world_stats_t> stats;
+        ECSMetrics last{};
+        std::deque<ECSMetrics> history;
+        uint32 historySize;
+        uint64 onAddEvents{0};
+        uint64 onRemoveEvents{0};
+        uint64 onSetEvents{0};
+        uint64 entitiesMoved{0};
+        //! Last move counted, the events of one move are received once per component
+        flecs::entity_t lastEntity{0};
+        const flecs::table_t* lastSource{nullptr};
+        const flecs::table_t* lastDestination{nullptr};
+
+        void countMove(flecs::entity_t entity, const flecs::table_t* source, const flecs::table_t* destination);
+    };
+
     class Modules {
     public:
         Modules(flecs::world& w);
         ~Modules();
+
+        /**
+         * Returns the pipeline running the systems of the SimulationPhase phases
+         */
+        flecs::entity getSimulationPipeline() const { return simulationPipeline; }
+
     private:
+        flecs::entity simulationPipeline;
+        flecs::entity pipelineModule;
+        flecs::entity metricsModule;
         flecs::entity renderModule;
         flecs::entity meshInstanceModule;
         flecs::entity transformModule;
+        flecs::entity streamingModule;
     };
 
 }
@@ -8,6 +8,7 @@ module lysa.ecs.systems;
 
 import lysa.log;
 import lysa.math;
+import lysa.ecs.profiler;
 
 namespace lysa::ecs {
 
@@ -24,21 +25,103 @@ namespace lysa::ecs {
           });
      }
 
+     static bool equals(const float4x4& a, const float4x4& b) {
+          return all(a[0] == b[0]) && all(a[1] == b[1]) && all(a[2] == b[2]) && all(a[3] == b[3]);
+     }
+
+     TransformInterpolation::Pose TransformModule::decompose(const float4x4& transform) {
+          const float3 scale{length(transform[0].xyz), length(transform[1].xyz), length(transform[2].xyz)};
+          // A zero scale axis carries no rotation, it is kept as is instead of dividing by zero
+          const auto axis = [](const float3& v, const float s) {
+               return s > 1e-6f ? v / s : v;
+          };
+          return {
+               .position = transform[3].xyz,
+               .rotation = quaternion{float3x3{
+                    axis(transform[0].xyz, scale.x), axis(transform[1].xyz, scale.y), axis(transform[2].xyz, scale.z)}},
+               .scale = scale,
+          };
+     }
+
+     float4x4 TransformModule::interpolate(
+          const TransformInterpolation::Pose& from,
+          const TransformInterpolation::Pose& to,
+          const float alpha) {
+          const auto sm = float4x4::scale(lerp(from.scale, to.scale, alpha));
+          const auto rm = float4x4{slerp(from.rotation, to.rotation, alpha)};
+          const auto tm = float4x4::translation(lerp(from.position, to.position, alpha));
+          return mul(mul(sm, rm), tm);
+     }
+
      TransformModule::TransformModule(const flecs::world& w) {
           w.module<TransformModule>();
           w.component<Transform>();
+          w.component<TransformInterpolation>();
           w.observer<Transform>()
             .event(flecs::OnSet)
             .event(flecs::OnAdd)
-            .each([](const flecs::entity& e, Transform& t) {
+            .run(profileRun("TransformModule.OnAdd|OnSet(Transform)"), [](const flecs::entity& e, Transform& t) {
                 //e.add<TransformUpdated>();
           });
          w.system<Transform, const TransformUpdated>()
-            .kind(flecs::OnUpdate)
-            .each([&](const flecs::entity& e, Transform& tr, const TransformUpdated&) {
+            .kind<FixedPostUpdate>()
+            .run(profileRun("TransformModule.updateGlobalTransform"), [&](const flecs::entity& e, Transform& tr, const TransformUpdated&) {
                 updateGlobalTransform(e, tr);
                 e.remove<TransformUpdated>();
         });
+         w.observer<TransformInterpolation, const Transform>()
+            .event(flecs::OnAdd)
+            .run(profileRun("TransformModule.OnAdd(TransformInterpolation)"), [](TransformInterpolation& ti, const Transform& tr) {
+                ti.current = decompose(tr.global);
+                ti.previous = ti.current;
+                ti.target = tr.global;
+                ti.moving = false;
+                ti.global = tr.global;
+         });
+         // Keeps the decomposed world transforms of the last two simulation steps,
+         // declared after the propagation system so it runs after it in FixedPostUpdate.
+         // The matrices are decomposed once per step instead of twice per entity and frame
+         w.system<TransformInterpolation, const Transform>()
+            .kind<FixedPostUpdate>()
+            .run([](flecs::iter& it) {
+                const auto profile = ProfilerScope{"TransformModule.snapshotInterpolation"};
+                while (it.next()) {
+                     auto ti = it.field<TransformInterpolation>(0);
+                     const auto tr = it.field<const Transform>(1);
+                     for (const auto i : it) {
+                          auto& t = ti[i];
+                          t.moving = !equals(t.target, tr[i].global);
+                          t.target = tr[i].global;
+                          t.previous = t.current;
+                          if (t.moving) {
+                               t.current = decompose(tr[i].global);
+                          }
+                     }
+                }
+         });
+         // Blends the last two simulation steps, table by table, before the mesh instances and cameras sync
+         w.system<TransformInterpolation>()
+            .kind(flecs::PreUpdate)
+            .run([](flecs::iter& it) {
+                const auto profile = ProfilerScope{"TransformModule.interpolate"};
+                const auto alpha = it.world().get<SimulationTime>().alpha;
+                while (it.next()) {
+                     auto ti = it.field<TransformInterpolation>(0);
+                     // Only the mesh instances consume Updated, the cameras read the blended transform each frame
+                     const auto tag = it.table().has<MeshInstance>();
+                     for (const auto i : it) {
+                          auto& t = ti[i];
+                          const auto global = t.moving ?
+                               interpolate(t.previous, t.current, alpha) :
+                               t.target;
+                          if (equals(t.global, global)) { continue; }
+                          t.global = global;
+                          if (tag) {
+                               it.entity(i).add<Updated>();
+                          }
+                     }
+                }
+         });
      }
 
 }